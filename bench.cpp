@@ -0,0 +1,503 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "renderer.h"
+#include "presenter.h"
+#include "primitives.h"
+
+// Microbenchmarks for the math, raster and present hot paths.
+// Results are printed as CSV, one benchmark per line, so runs can be compared by scripts:
+//     benchmark,ns_per_op,triangles_per_sec,cells_per_sec
+// Rates that do not apply to a benchmark are 0. Pass a substring to only run matching benchmarks.
+
+// Gives the benchmarks access to the private pipeline stages
+struct RendererBench
+{
+    static iVec2 worldToScreen(Renderer &renderer, const fVec3 &worldPos, const fMat4 &transform)
+    {
+        return renderer.worldToScreen(worldPos, transform);
+    }
+    static void transformVertices(Renderer &renderer, const Vertex *vertices, int verticesCount, const fMat4 &transform, ScreenVertex *out)
+    {
+        renderer.transformVertices(vertices, verticesCount, transform, nullptr, out);
+    }
+    static const Framebuffer &getPixels(Renderer &renderer)
+    {
+        return *renderer.pixels;
+    }
+    static void tri(Renderer &renderer, const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2)
+    {
+        renderer.tri(v0, v1, v2);
+    }
+};
+
+namespace
+{
+    // Every timed run lasts at least this long; the median of the runs is reported
+    const double MIN_RUN_SECONDS = 0.05;
+    const int RUNS = 5;
+
+    const char *filter = nullptr;
+
+    // Keep the compiler from optimizing away a result
+    template <typename T>
+    inline void keep(const T &value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Median time of one call to op, in nanoseconds
+    template <typename Op>
+    double measure(Op &&op)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        auto runFor = [&](long iterations)
+        {
+            auto start = Clock::now();
+            for (long i = 0; i < iterations; ++i)
+                op();
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        // Double the iteration count until a run is long enough to time reliably
+        long iterations = 1;
+        while (runFor(iterations) < MIN_RUN_SECONDS)
+            iterations *= 2;
+
+        double samples[RUNS];
+        for (double &sample : samples)
+            sample = runFor(iterations) * 1e9 / iterations;
+
+        std::sort(samples, samples + RUNS);
+        return samples[RUNS / 2];
+    }
+
+    bool selected(const char *name)
+    {
+        return !filter || std::strstr(name, filter);
+    }
+
+    // Print one result; triangles and cells are the work done by a single op
+    void report(const char *name, double nsPerOp, double triangles = 0, double cells = 0)
+    {
+        std::printf("%s,%.2f,%.0f,%.0f\n", name, nsPerOp, triangles * 1e9 / nsPerOp, cells * 1e9 / nsPerOp);
+        std::fflush(stdout);
+    }
+
+    // True if this CPU can run the SIMD kernels of the named instruction set
+    bool supportsKernel(const char *name)
+    {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+        __builtin_cpu_init();
+
+        if (std::strcmp(name, "sse2") == 0)
+            return __builtin_cpu_supports("sse2");
+        if (std::strcmp(name, "avx2") == 0)
+            return __builtin_cpu_supports("avx2");
+#endif
+
+        return false;
+    }
+
+    // The span kernels this CPU can run
+    std::vector<const raster::SpanKernels *> supportedKernels()
+    {
+        std::vector<const raster::SpanKernels *> kernels = {&raster::getScalarKernels()};
+
+        if (supportsKernel("sse2"))
+            kernels.push_back(&raster::getSSE2Kernels());
+        if (supportsKernel("avx2"))
+            kernels.push_back(&raster::getAVX2Kernels());
+
+        return kernels;
+    }
+
+    // Indexed mesh owned by the benchmark
+    struct Geometry
+    {
+        std::vector<Vertex> vertices;
+        std::vector<int> indices;
+
+        int getTriangleCount() const
+        {
+            return static_cast<int>(indices.size() / 3);
+        }
+    };
+
+    Geometry makeCube()
+    {
+        Cube cube;
+        Geometry geometry;
+
+        geometry.vertices.assign(cube.getVertices(), cube.getVertices() + cube.getVerticesCount());
+        geometry.indices.assign(cube.getIndices(), cube.getIndices() + cube.getIndicesCount());
+
+        return geometry;
+    }
+
+    // Unit UV sphere with rings * segments * 2 triangles (minus the degenerate ones at the poles)
+    Geometry makeSphere(int rings, int segments)
+    {
+        Geometry geometry;
+
+        for (int ring = 0; ring <= rings; ++ring)
+        {
+            float theta = ring * static_cast<float>(M_PI) / rings;
+
+            for (int segment = 0; segment <= segments; ++segment)
+            {
+                float phi = segment * 2.f * static_cast<float>(M_PI) / segments;
+                fVec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+                geometry.vertices.push_back({normal, normal});
+            }
+        }
+
+        for (int ring = 0; ring < rings; ++ring)
+        {
+            for (int segment = 0; segment < segments; ++segment)
+            {
+                int a = ring * (segments + 1) + segment;
+                int b = a + segments + 1;
+
+                geometry.indices.insert(geometry.indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+            }
+        }
+
+        return geometry;
+    }
+
+    ScreenVertex screenVertex(float x, float y)
+    {
+        ScreenVertex vertex;
+        vertex.position = fVec2(x, y);
+        vertex.depth = .5f;
+        vertex.invW = 1.f;
+        vertex.normals = fVec3(0, 0, 1);
+
+        return vertex;
+    }
+
+    void benchMath()
+    {
+        if (selected("math/Mat_mul_4x4"))
+        {
+            fMat a = fMat::identity(4), b = fMat::identity(4);
+            a.data[0][3] = 2.f;
+            b.data[1][2] = 3.f;
+
+            report("math/Mat_mul_4x4", measure([&]
+                                               {
+                fMat c = a * b;
+                keep(c.data[0][0]); }));
+        }
+
+        if (selected("math/Mat4_mul"))
+        {
+            fMat4 a = fMat4::perspective(45.f, 2.f, .01f, 1000.f);
+            fMat4 b = fMat4::lookAt(fVec3(0, 1, 5), fVec3(0, 0, 0), fVec3(0, 1, 0));
+
+            report("math/Mat4_mul", measure([&]
+                                            {
+                keep(a);
+                fMat4 c = a * b;
+                keep(c); }));
+        }
+
+        if (selected("math/Mat4_mul_Vec4"))
+        {
+            fMat4 m = fMat4::perspective(45.f, 2.f, .01f, 1000.f);
+            fVec4 v(fVec3(1, 2, -3), 1.f);
+
+            report("math/Mat4_mul_Vec4", measure([&]
+                                                 {
+                keep(v);
+                fVec4 r = m * v;
+                keep(r); }));
+        }
+
+        if (selected("math/Vec3_rotate"))
+        {
+            fVec3 v(1, 2, 3), origin(0, 0, 0), angles(1, 1, 1);
+
+            report("math/Vec3_rotate", measure([&]
+                                               {
+                keep(v);
+                fVec3 r = v.rotate(origin, angles);
+                keep(r); }));
+        }
+    }
+
+    void benchVertex()
+    {
+        Renderer renderer(160, 48, RenderTarget::Offscreen);
+        renderer.createProjectionMatrix(45.f, .01f, 1000.f);
+        renderer.createViewMatrix(0.f, 0.f, 5.f);
+
+        fMat4 transform = renderer.getViewProjectionMatrix();
+
+        if (selected("vertex/worldToScreen"))
+        {
+            fVec3 position(.5f, -.25f, 1.f);
+
+            report("vertex/worldToScreen", measure([&]
+                                                   {
+                keep(position);
+                iVec2 screen = RendererBench::worldToScreen(renderer, position, transform);
+                keep(screen); }));
+        }
+
+        // Vertex stage over a large model, interleaved and as a vertex buffer with every batch
+        // kernel (one op is one vertex)
+        Geometry sphere = makeSphere(256, 512);
+        const int count = static_cast<int>(sphere.vertices.size());
+        std::vector<ScreenVertex> out(count);
+
+        if (selected("vertex/transform_aos"))
+            report("vertex/transform_aos", measure([&]
+                                                   { RendererBench::transformVertices(renderer, sphere.vertices.data(), count, transform, out.data()); }) /
+                                               count);
+
+        VertexBuffer vertexBuffer(sphere.vertices.data(), count);
+        transform::Batch batch = {transform, nullptr, 160.f, 48.f};
+
+        for (transform::TransformKernel kernel : {transform::transformScalar, transform::transformSSE2, transform::transformAVX2})
+        {
+            char name[64];
+            std::snprintf(name, sizeof(name), "vertex/transform_soa/%s", transform::getTransformKernelName(kernel));
+            if (!selected(name) || (kernel != transform::transformScalar && !supportsKernel(transform::getTransformKernelName(kernel))))
+                continue;
+
+            report(name, measure([&]
+                                 {
+                kernel(batch, vertexBuffer, 0, count, out.data());
+                keep(out[0]); }) /
+                             count);
+        }
+    }
+
+    void benchTriangles()
+    {
+        const int width = 160, height = 48;
+
+        struct Shape
+        {
+            const char *name;
+            ScreenVertex v0, v1, v2;
+        };
+
+        // Wound so that they are front facing in screen space (y down)
+        const Shape shapes[] = {
+            {"small", screenVertex(10.3f, 10.2f), screenVertex(13.1f, 12.7f), screenVertex(10.6f, 13.4f)},
+            {"large", screenVertex(2.f, 1.f), screenVertex(158.f, 3.f), screenVertex(20.f, 47.f)},
+            {"sliver", screenVertex(1.f, 1.f), screenVertex(159.f, 46.f), screenVertex(157.f, 47.f)}};
+
+        // Per-cell shading keeps the plain names, the cheaper modes get a suffix
+        struct Mode
+        {
+            const char *suffix;
+            raster::ShadingMode mode;
+        };
+        const Mode modes[] = {{"", raster::ShadingMode::PerCell},
+                              {"_gouraud", raster::ShadingMode::Gouraud},
+                              {"_flat", raster::ShadingMode::Flat}};
+
+        for (const raster::SpanKernels *kernels : supportedKernels())
+        {
+            for (const Mode &mode : modes)
+            {
+                for (const Shape &shape : shapes)
+                {
+                    char name[64];
+                    std::snprintf(name, sizeof(name), "raster/tri_%s%s/%s", shape.name, mode.suffix, kernels->name);
+                    if (!selected(name))
+                        continue;
+
+                    // Without depth testing every call shades the whole triangle again
+                    Renderer renderer(width, height, RenderTarget::Offscreen);
+                    renderer.setSpanKernels(*kernels);
+                    renderer.setShadingMode(mode.mode);
+                    renderer.setDepthTest(false);
+
+                    renderer.begin();
+                    RendererBench::tri(renderer, shape.v0, shape.v1, shape.v2);
+
+                    const Framebuffer &frame = renderer.getFramebuffer();
+                    int cells = 0;
+                    for (int y = 0; y < height; ++y)
+                        for (int x = 0; x < width; ++x)
+                            cells += frame.glyphRow(y)[x] != 0;
+
+                    report(name, measure([&]
+                                         { RendererBench::tri(renderer, shape.v0, shape.v1, shape.v2); }),
+                           1, cells);
+                }
+            }
+        }
+    }
+
+    // Draw one frame of a sphere seen from the given angle into the renderer
+    void drawFrame(Renderer &renderer, Geometry &geometry, int frame)
+    {
+        float angle = (frame % 16) * static_cast<float>(M_PI) / 8.f;
+        renderer.lookAt(fVec3(std::sin(angle) * 3.f, 1.f, std::cos(angle) * 3.f), fVec3(0, 0, 0), fVec3(0, 1, 0));
+
+        renderer.begin();
+        renderer.draw(geometry.vertices.data(), static_cast<int>(geometry.vertices.size()),
+                      geometry.indices.data(), static_cast<int>(geometry.indices.size()));
+        renderer.render();
+    }
+
+    void benchPresent()
+    {
+        Geometry sphere = makeSphere(16, 32);
+        const int sizes[][2] = {{80, 24}, {160, 48}};
+
+        // Without colors, and with a colored sphere on the default background
+        struct ColorDepth
+        {
+            const char *suffix;
+            color::Depth depth;
+        };
+        const ColorDepth depths[] = {{"", color::Depth::None}, {"_256", color::Depth::Ansi256}, {"_truecolor", color::Depth::TrueColor}};
+
+        for (const int *size : sizes)
+        {
+            for (PresentMode mode : {PresentMode::Full, PresentMode::Delta})
+            {
+                for (const ColorDepth &depth : depths)
+                {
+                    char name[64];
+                    std::snprintf(name, sizeof(name), "present/encode_%s%s/%dx%d",
+                                  mode == PresentMode::Full ? "full" : "delta", depth.suffix, size[0], size[1]);
+                    if (!selected(name))
+                        continue;
+
+                    // Render two frames from different angles to present in turn
+                    Renderer renderer(size[0], size[1], RenderTarget::Offscreen);
+                    renderer.createProjectionMatrix(45.f, .01f, 1000.f);
+                    renderer.setColorDepth(depth.depth);
+                    renderer.setColor(color::rgb(255, 176, 64), color::rgb(32, 32, 96));
+
+                    int planes = Framebuffer::GLYPH | Framebuffer::COLOR;
+                    Framebuffer first(size[0], size[1], planes), second(size[0], size[1], planes);
+                    Framebuffer *frames[2] = {&first, &second};
+                    for (int i = 0; i < 2; ++i)
+                    {
+                        drawFrame(renderer, sphere, i);
+                        frames[i]->copyGlyphs(renderer.getFramebuffer());
+                        if (depth.depth != color::Depth::None)
+                            frames[i]->copyColors(renderer.getFramebuffer());
+                    }
+
+                    // Encode into a sink that drops the bytes, so the terminal is not measured
+                    Presenter presenter(size[0], size[1], renderer.getPalette());
+                    presenter.setMode(mode);
+                    presenter.setColorDepth(depth.depth);
+                    presenter.setOutput([](const iovec *parts, int count)
+                                        { keep(parts[0]); });
+
+                    int frame = 0;
+                    report(name, measure([&]
+                                         { presenter.present(*frames[frame++ & 1], 0.f); }),
+                           0, size[0] * size[1]);
+                }
+            }
+        }
+    }
+
+    void benchPack()
+    {
+        Geometry sphere = makeSphere(16, 32);
+        const int sizes[][2] = {{80, 24}, {160, 48}};
+
+        struct Mode
+        {
+            const char *name;
+            CellMode mode;
+        };
+        const Mode modes[] = {{"half_block", CellMode::HalfBlock}, {"braille", CellMode::Braille}};
+
+        for (const int *size : sizes)
+        {
+            for (const Mode &mode : modes)
+            {
+                char name[64];
+                std::snprintf(name, sizeof(name), "pack/%s/%dx%d", mode.name, size[0], size[1]);
+                if (!selected(name))
+                    continue;
+
+                // Pack the pixels of a rendered frame again and again (one op is one frame)
+                Renderer renderer(size[0], size[1], RenderTarget::Offscreen, mode.mode);
+                renderer.createProjectionMatrix(45.f, .01f, 1000.f);
+                drawFrame(renderer, sphere, 1);
+
+                const Framebuffer &frame = renderer.getFramebuffer();
+                Framebuffer cells(frame.getWidth(), frame.getHeight(), Framebuffer::GLYPH);
+
+                report(name, measure([&]
+                                     { subcell::pack(mode.mode, RendererBench::getPixels(renderer), cells);
+                                       keep(cells.glyphRow(0)[0]); }),
+                       0, frame.getWidth() * frame.getHeight());
+            }
+        }
+    }
+
+    void benchScenes()
+    {
+        struct Scene
+        {
+            const char *name;
+            Geometry geometry;
+        };
+
+        Scene scenes[] = {
+            {"cube", makeCube()},
+            {"sphere_512", makeSphere(16, 16)},
+            {"sphere_8k", makeSphere(64, 64)}};
+
+        const int sizes[][2] = {{80, 24}, {160, 48}, {320, 96}};
+
+        for (Scene &scene : scenes)
+        {
+            for (const int *size : sizes)
+            {
+                char name[64];
+                std::snprintf(name, sizeof(name), "scene/%s/%dx%d", scene.name, size[0], size[1]);
+                if (!selected(name))
+                    continue;
+
+                // Offscreen without an output: vertex, primitive and raster stages only
+                Renderer renderer(size[0], size[1], RenderTarget::Offscreen);
+                renderer.createProjectionMatrix(45.f, .01f, 1000.f);
+
+                int frame = 0;
+                report(name, measure([&]
+                                     { drawFrame(renderer, scene.geometry, frame++); }),
+                       scene.geometry.getTriangleCount(), size[0] * size[1]);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        filter = argv[1];
+
+    std::printf("benchmark,ns_per_op,triangles_per_sec,cells_per_sec\n");
+
+    benchMath();
+    benchVertex();
+    benchTriangles();
+    benchPresent();
+    benchPack();
+    benchScenes();
+
+    return 0;
+}
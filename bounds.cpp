@@ -0,0 +1,142 @@
+#include "bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+BoundingBox BoundingBox::transformed(const fMat4 &transform) const
+{
+    const float(&m)[4][4] = transform.data;
+
+    // Transform the center, and project the extent on every axis (Arvo)
+    fVec3 center = getCenter(), extent = getExtent();
+
+    fVec3 newCenter(m[0][0] * center.x + m[0][1] * center.y + m[0][2] * center.z + m[0][3],
+                    m[1][0] * center.x + m[1][1] * center.y + m[1][2] * center.z + m[1][3],
+                    m[2][0] * center.x + m[2][1] * center.y + m[2][2] * center.z + m[2][3]);
+    fVec3 newExtent(std::fabs(m[0][0]) * extent.x + std::fabs(m[0][1]) * extent.y + std::fabs(m[0][2]) * extent.z,
+                    std::fabs(m[1][0]) * extent.x + std::fabs(m[1][1]) * extent.y + std::fabs(m[1][2]) * extent.z,
+                    std::fabs(m[2][0]) * extent.x + std::fabs(m[2][1]) * extent.y + std::fabs(m[2][2]) * extent.z);
+
+    return {newCenter - newExtent, newCenter + newExtent};
+}
+
+BoundingSphere BoundingSphere::transformed(const fMat4 &transform) const
+{
+    const float(&m)[4][4] = transform.data;
+
+    BoundingSphere result;
+    result.center = fVec3(m[0][0] * center.x + m[0][1] * center.y + m[0][2] * center.z + m[0][3],
+                          m[1][0] * center.x + m[1][1] * center.y + m[1][2] * center.z + m[1][3],
+                          m[2][0] * center.x + m[2][1] * center.y + m[2][2] * center.z + m[2][3]);
+
+    // Longest transformed axis
+    float scale = 0.f;
+    for (int i = 0; i < 3; ++i)
+        scale = std::max(scale, m[0][i] * m[0][i] + m[1][i] * m[1][i] + m[2][i] * m[2][i]);
+
+    result.radius = radius * std::sqrt(scale);
+    return result;
+}
+
+namespace
+{
+    template <typename Position>
+    void computeBounds(int count, Position position, BoundingBox &box, BoundingSphere &sphere)
+    {
+        box = BoundingBox();
+        sphere = BoundingSphere();
+
+        if (count <= 0)
+            return;
+
+        box.min = box.max = position(0);
+        for (int i = 1; i < count; ++i)
+        {
+            fVec3 p = position(i);
+            box.min = fVec3(std::min(box.min.x, p.x), std::min(box.min.y, p.y), std::min(box.min.z, p.z));
+            box.max = fVec3(std::max(box.max.x, p.x), std::max(box.max.y, p.y), std::max(box.max.z, p.z));
+        }
+
+        // Sphere around the box center, just large enough for the farthest vertex
+        sphere.center = box.getCenter();
+
+        float radius = 0.f;
+        for (int i = 0; i < count; ++i)
+        {
+            fVec3 d = position(i) - sphere.center;
+            radius = std::max(radius, d.dot(d));
+        }
+
+        sphere.radius = std::sqrt(radius);
+    }
+}
+
+void computeBounds(const Vertex *vertices, int count, BoundingBox &box, BoundingSphere &sphere)
+{
+    computeBounds(count, [vertices](int i)
+                  { return vertices[i].position; },
+                  box, sphere);
+}
+void computeBounds(const VertexBuffer &vertices, BoundingBox &box, BoundingSphere &sphere)
+{
+    const float *x = vertices.getStream(VertexBuffer::POSITION_X);
+    const float *y = vertices.getStream(VertexBuffer::POSITION_Y);
+    const float *z = vertices.getStream(VertexBuffer::POSITION_Z);
+
+    computeBounds(vertices.getCount(), [x, y, z](int i)
+                  { return fVec3(x[i], y[i], z[i]); },
+                  box, sphere);
+}
+
+Frustum::Frustum(const fMat4 &viewProjection)
+{
+    const float(&m)[4][4] = viewProjection.data;
+
+    // A point is inside if -w <= x <= w, -w <= y <= w and 0 <= z <= w in clip space; each
+    // inequality is a plane made of rows of the matrix (Gribb and Hartmann)
+    fVec4 x(m[0][0], m[0][1], m[0][2], m[0][3]);
+    fVec4 y(m[1][0], m[1][1], m[1][2], m[1][3]);
+    fVec4 z(m[2][0], m[2][1], m[2][2], m[2][3]);
+    fVec4 w(m[3][0], m[3][1], m[3][2], m[3][3]);
+
+    planes[0] = w + x; // Left
+    planes[1] = w - x; // Right
+    planes[2] = w + y; // Bottom
+    planes[3] = w - y; // Top
+    planes[4] = z;     // Near
+    planes[5] = w - z; // Far
+
+    // Unit normals, so the plane equation gives the distance for the sphere test
+    for (fVec4 &plane : planes)
+    {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.f)
+            plane = plane * (1.f / length);
+    }
+}
+
+bool Frustum::intersects(const BoundingSphere &sphere) const
+{
+    for (const fVec4 &plane : planes)
+    {
+        if (plane.x * sphere.center.x + plane.y * sphere.center.y + plane.z * sphere.center.z + plane.w < -sphere.radius)
+            return false;
+    }
+
+    return true;
+}
+bool Frustum::intersects(const BoundingBox &box) const
+{
+    for (const fVec4 &plane : planes)
+    {
+        // The corner farthest along the plane normal
+        float x = plane.x >= 0.f ? box.max.x : box.min.x;
+        float y = plane.y >= 0.f ? box.max.y : box.min.y;
+        float z = plane.z >= 0.f ? box.max.z : box.min.z;
+
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.f)
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "math.h"
+#include "vertex.h"
+#include "vertexbuffer.h"
+
+// Axis-aligned bounding box
+struct BoundingBox
+{
+    fVec3 min, max;
+
+    inline fVec3 getCenter() const
+    {
+        return (min + max) * .5f;
+    }
+    inline fVec3 getExtent() const
+    {
+        return (max - min) * .5f;
+    }
+
+    // Box around the transformed box (exact for the corners, conservative for the contents)
+    BoundingBox transformed(const fMat4 &transform) const;
+};
+
+// Bounding sphere
+struct BoundingSphere
+{
+    fVec3 center;
+    float radius = 0.f;
+
+    // Sphere around the transformed sphere (the radius grows with the largest axis scale)
+    BoundingSphere transformed(const fMat4 &transform) const;
+};
+
+// Bounds of interleaved or structure-of-arrays vertices (empty bounds at the origin if count is 0)
+void computeBounds(const Vertex *vertices, int count, BoundingBox &box, BoundingSphere &sphere);
+void computeBounds(const VertexBuffer &vertices, BoundingBox &box, BoundingSphere &sphere);
+
+// Clip volume of a view projection matrix as six planes, limited to the depth range the
+// vertex stage keeps (0 <= z <= w)
+class Frustum
+{
+public:
+    Frustum() = default;
+    explicit Frustum(const fMat4 &viewProjection);
+
+    // Conservative tests: false only if the volume is entirely outside one of the planes
+    bool intersects(const BoundingSphere &sphere) const;
+    bool intersects(const BoundingBox &box) const;
+
+private:
+    // Planes as (normal, distance) with unit normals pointing inside
+    fVec4 planes[6];
+};
@@ -0,0 +1,115 @@
+#include "clip.h"
+
+#include <algorithm>
+
+#include "raster.h"
+
+namespace
+{
+    // Signed distance-like value of a position to a plane, non-negative inside
+    inline float distance(const fVec4 &p, unsigned plane, const clip::GuardBand &guard)
+    {
+        switch (plane)
+        {
+        case clip::PLANE_NEAR:
+            return p.z;
+        case clip::PLANE_FAR:
+            return p.w - p.z;
+        case clip::PLANE_LEFT:
+            return p.x + guard.x * p.w;
+        case clip::PLANE_RIGHT:
+            return guard.x * p.w - p.x;
+        case clip::PLANE_BOTTOM:
+            return p.y + guard.y * p.w;
+        default:
+            return guard.y * p.w - p.y;
+        }
+    }
+
+    inline clip::Vertex lerp(const clip::Vertex &a, const clip::Vertex &b, float t)
+    {
+        return {a.position + (b.position - a.position) * t, a.normals + (b.normals - a.normals) * t};
+    }
+}
+
+clip::GuardBand clip::getGuardBand(int width, int height)
+{
+    // Screen x = (ndc + 1) / 2 * width, solved for |screen x| <= GUARD_BAND / 2
+    return {raster::GUARD_BAND / width - 1.f, raster::GUARD_BAND / height - 1.f};
+}
+
+unsigned clip::getOutcode(const fVec4 &position, const GuardBand &guard)
+{
+    unsigned outcode = 0;
+    for (unsigned plane = 1; plane < 1u << PLANE_COUNT; plane <<= 1)
+        if (distance(position, plane, guard) < 0.f)
+            outcode |= plane;
+
+    return outcode;
+}
+
+int clip::clipPolygon(Vertex *polygon, int count, unsigned planes, const GuardBand &guard)
+{
+    Vertex scratch[MAX_POLYGON];
+
+    for (unsigned plane = 1; plane < 1u << PLANE_COUNT && count >= 3; plane <<= 1)
+    {
+        if (!(planes & plane))
+            continue;
+
+        // Keep the inside vertices, adding one where an edge crosses the plane
+        int clippedCount = 0;
+        const Vertex *previous = &polygon[count - 1];
+        float previousDistance = distance(previous->position, plane, guard);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const Vertex *current = &polygon[i];
+            float currentDistance = distance(current->position, plane, guard);
+
+            if ((previousDistance >= 0.f) != (currentDistance >= 0.f))
+                scratch[clippedCount++] = lerp(*previous, *current, previousDistance / (previousDistance - currentDistance));
+            if (currentDistance >= 0.f)
+                scratch[clippedCount++] = *current;
+
+            previous = current;
+            previousDistance = currentDistance;
+        }
+
+        count = clippedCount;
+        for (int i = 0; i < count; ++i)
+            polygon[i] = scratch[i];
+    }
+
+    return count;
+}
+
+bool clip::clipLine(fVec4 &start, fVec4 &end, unsigned planes, const GuardBand &guard)
+{
+    // Parametric clipping: shrink [enter, leave] along the segment for every plane
+    float enter = 0.f, leave = 1.f;
+
+    for (unsigned plane = 1; plane < 1u << PLANE_COUNT; plane <<= 1)
+    {
+        if (!(planes & plane))
+            continue;
+
+        float d0 = distance(start, plane, guard), d1 = distance(end, plane, guard);
+        if (d0 < 0.f && d1 < 0.f)
+            return false;
+
+        if (d0 < 0.f)
+            enter = std::max(enter, d0 / (d0 - d1));
+        else if (d1 < 0.f)
+            leave = std::min(leave, d0 / (d0 - d1));
+    }
+
+    if (enter > leave)
+        return false;
+
+    fVec4 delta = end - start;
+    end = start + delta * leave;
+    start = start + delta * enter;
+
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "math.h"
+
+namespace clip
+{
+    // Vertex in clip space with the attributes interpolated across a clipped edge
+    struct Vertex
+    {
+        fVec4 position;
+        fVec3 normals;
+    };
+
+    // Planes, as outcode bits of the vertices outside them
+    const unsigned PLANE_NEAR = 1 << 0;   // z < 0
+    const unsigned PLANE_FAR = 1 << 1;    // z > w
+    const unsigned PLANE_LEFT = 1 << 2;   // x < -guard.x * w
+    const unsigned PLANE_RIGHT = 1 << 3;  // x > guard.x * w
+    const unsigned PLANE_BOTTOM = 1 << 4; // y < -guard.y * w
+    const unsigned PLANE_TOP = 1 << 5;    // y > guard.y * w
+    const unsigned PLANE_COUNT = 6;
+
+    // Clipping never adds more than one vertex per plane
+    const int MAX_POLYGON = 3 + PLANE_COUNT;
+
+    // Guard band in normalized device coordinates: x/y within it stay in the fixed-point
+    // range of the rasterizer, so only the screen edges beyond it need geometric clipping
+    struct GuardBand
+    {
+        float x, y;
+    };
+
+    // Half of raster::GUARD_BAND on a width x height target, so rounding never pushes a
+    // clipped vertex past the rasterizer limit
+    GuardBand getGuardBand(int width, int height);
+
+    unsigned getOutcode(const fVec4 &position, const GuardBand &guard);
+
+    // Sutherland-Hodgman: clip the polygon against every plane in planes, in place.
+    // polygon must have room for MAX_POLYGON vertices. Returns the new vertex count
+    // (below 3 if nothing is left). Winding is preserved.
+    int clipPolygon(Vertex *polygon, int count, unsigned planes, const GuardBand &guard);
+
+    // Clip a segment against every plane in planes, returns false if nothing is left
+    bool clipLine(fVec4 &start, fVec4 &end, unsigned planes, const GuardBand &guard);
+}
@@ -0,0 +1,187 @@
+#include "color.h"
+
+namespace
+{
+    // xterm's values of the 16 ANSI colors
+    const color::Rgb ANSI_COLORS[16] = {
+        0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+        0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF};
+
+    // Channel levels of the 6x6x6 color cube of the 256-color palette
+    const int CUBE_LEVELS[6] = {0, 95, 135, 175, 215, 255};
+
+    inline int red(color::Rgb color)
+    {
+        return color >> 16 & 0xFF;
+    }
+    inline int green(color::Rgb color)
+    {
+        return color >> 8 & 0xFF;
+    }
+    inline int blue(color::Rgb color)
+    {
+        return color & 0xFF;
+    }
+
+    inline int distance(int r0, int g0, int b0, int r1, int g1, int b1)
+    {
+        return (r0 - r1) * (r0 - r1) + (g0 - g1) * (g0 - g1) + (b0 - b1) * (b0 - b1);
+    }
+
+    // Nearest level of the color cube
+    inline int cubeIndex(int channel)
+    {
+        return channel < 48 ? 0 : channel < 115 ? 1 : (channel - 35) / 40;
+    }
+
+    uint32_t quantizeAnsi16(color::Rgb color)
+    {
+        int r = red(color), g = green(color), b = blue(color);
+
+        int best = 0, bestDistance = 3 * 256 * 256;
+        for (int i = 0; i < 16; ++i)
+        {
+            int d = distance(r, g, b, red(ANSI_COLORS[i]), green(ANSI_COLORS[i]), blue(ANSI_COLORS[i]));
+            if (d < bestDistance)
+            {
+                best = i;
+                bestDistance = d;
+            }
+        }
+
+        return best;
+    }
+
+    uint32_t quantizeAnsi256(color::Rgb color)
+    {
+        int r = red(color), g = green(color), b = blue(color);
+
+        // Nearest entry of the color cube (16-231)
+        int cr = cubeIndex(r), cg = cubeIndex(g), cb = cubeIndex(b);
+        int cubeDistance = distance(r, g, b, CUBE_LEVELS[cr], CUBE_LEVELS[cg], CUBE_LEVELS[cb]);
+
+        // Nearest entry of the gray ramp (232-255, from 8 to 238 in steps of 10)
+        int average = (r + g + b) / 3;
+        int gray = average < 8 ? 0 : average > 238 ? 23 : (average - 3) / 10;
+        int level = 8 + 10 * gray;
+        int grayDistance = distance(r, g, b, level, level, level);
+
+        return grayDistance < cubeDistance ? 232 + gray : 16 + 36 * cr + 6 * cg + cb;
+    }
+
+    // Append a number in [0, 255]
+    inline char *appendByte(char *out, uint32_t value)
+    {
+        if (value >= 100)
+            *out++ = static_cast<char>('0' + value / 100);
+        if (value >= 10)
+            *out++ = static_cast<char>('0' + value / 10 % 10);
+        *out++ = static_cast<char>('0' + value % 10);
+
+        return out;
+    }
+
+    // Append the parameters selecting one color (base is 30 for the foreground, 40 for the background)
+    char *appendParameters(char *out, uint32_t quantized, color::Depth depth, uint32_t base)
+    {
+        if (quantized == color::DEFAULT)
+            return appendByte(out, base + 9);
+
+        if (depth == color::Depth::Ansi16)
+            return appendByte(out, quantized < 8 ? base + quantized : base + 60 + quantized - 8);
+
+        out = appendByte(out, base + 8);
+        if (depth == color::Depth::Ansi256)
+        {
+            *out++ = ';';
+            *out++ = '5';
+            *out++ = ';';
+            return appendByte(out, quantized);
+        }
+
+        *out++ = ';';
+        *out++ = '2';
+        *out++ = ';';
+        out = appendByte(out, red(quantized));
+        *out++ = ';';
+        out = appendByte(out, green(quantized));
+        *out++ = ';';
+        return appendByte(out, blue(quantized));
+    }
+}
+
+uint32_t color::quantize(Rgb color, Depth depth)
+{
+    if (color == DEFAULT)
+        return DEFAULT;
+
+    switch (depth)
+    {
+    case Depth::Ansi16:
+        return quantizeAnsi16(color);
+    case Depth::Ansi256:
+        return quantizeAnsi256(color);
+    case Depth::TrueColor:
+        return color & 0xFFFFFF;
+    default:
+        return DEFAULT;
+    }
+}
+
+void color::Encoder::setDepth(Depth depth)
+{
+    this->depth = depth;
+
+    // Earlier quantizations are for another depth
+    lastColor = lastQuantized = CellColor();
+    reset();
+}
+
+void color::Encoder::reset()
+{
+    current = CellColor();
+}
+
+char *color::Encoder::endRow(char *out)
+{
+    if (current.background == DEFAULT)
+        return out;
+
+    CellColor quantized = current;
+    quantized.background = DEFAULT;
+    return appendChange(out, quantized);
+}
+
+int color::Encoder::getChangeLength() const
+{
+    // "\033[38;2;r;g;bm", "\033[38;5;nm" or "\033[9nm" with typical digit counts
+    switch (depth)
+    {
+    case Depth::TrueColor:
+        return 17;
+    case Depth::Ansi256:
+        return 10;
+    default:
+        return 5;
+    }
+}
+
+char *color::Encoder::appendChange(char *out, const CellColor &quantized)
+{
+    *out++ = '\033';
+    *out++ = '[';
+
+    if (quantized.foreground != current.foreground)
+    {
+        out = appendParameters(out, quantized.foreground, depth, 30);
+        if (quantized.background != current.background)
+            *out++ = ';';
+    }
+    if (quantized.background != current.background)
+        out = appendParameters(out, quantized.background, depth, 40);
+
+    *out++ = 'm';
+
+    current = quantized;
+    return out;
+}
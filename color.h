@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+
+namespace color
+{
+    // 24-bit color as 0xRRGGBB
+    typedef uint32_t Rgb;
+
+    // The terminal's own foreground or background color
+    const Rgb DEFAULT = 0xFF000000;
+
+    inline Rgb rgb(int r, int g, int b)
+    {
+        return static_cast<Rgb>(r << 16 | g << 8 | b);
+    }
+
+    // Color with every channel scaled by factor in [0, 1]; DEFAULT stays DEFAULT, the
+    // terminal's own color being unknown
+    inline Rgb scale(Rgb color, float factor)
+    {
+        if (color == DEFAULT)
+            return DEFAULT;
+
+        return rgb(static_cast<int>((color >> 16 & 0xFF) * factor + .5f),
+                   static_cast<int>((color >> 8 & 0xFF) * factor + .5f),
+                   static_cast<int>((color & 0xFF) * factor + .5f));
+    }
+
+    // Colors a terminal can show: none (the cells are written without color escapes), the 16
+    // ANSI colors, the xterm 256-color palette or 24-bit truecolor
+    enum class Depth
+    {
+        None,
+        Ansi16,
+        Ansi256,
+        TrueColor
+    };
+
+    // Foreground and background of a cell
+    struct CellColor
+    {
+        Rgb foreground = DEFAULT;
+        Rgb background = DEFAULT;
+
+        inline bool operator==(const CellColor &other) const
+        {
+            return foreground == other.foreground && background == other.background;
+        }
+        inline bool operator!=(const CellColor &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    // Longest sequence Encoder::append writes ("\033[38;2;255;255;255;48;2;255;255;255m")
+    const int MAX_SGR_LENGTH = 36;
+
+    // Nearest color the terminal can show: the color itself for TrueColor, or a palette index
+    // (0-15 for Ansi16, 16-255 for Ansi256). DEFAULT stays DEFAULT.
+    uint32_t quantize(Rgb color, Depth depth);
+
+    // Tracks the colors the terminal is set to and appends an SGR sequence only when a cell
+    // changes them after quantization, so runs of one color cost a single escape
+    class Encoder
+    {
+    public:
+        void setDepth(Depth depth);
+        inline Depth getDepth() const
+        {
+            return depth;
+        }
+
+        // The terminal is back at its default colors (after a reset sequence)
+        void reset();
+
+        // Append whatever sequence switches the terminal to color and return the end of the
+        // written bytes (at most MAX_SGR_LENGTH)
+        inline char *append(char *out, const CellColor &color)
+        {
+            // Neighbouring cells mostly share their color, so the last quantization is kept
+            if (color != lastColor)
+            {
+                lastColor = color;
+                lastQuantized = {quantize(color.foreground, depth), quantize(color.background, depth)};
+            }
+
+            if (lastQuantized == current)
+                return out;
+
+            return appendChange(out, lastQuantized);
+        }
+
+        // Drop a non-default background before a newline, so a scrolling terminal does not
+        // fill the new line with it
+        char *endRow(char *out);
+
+        // Typical length of a sequence changing one of the colors, to estimate encoded sizes
+        int getChangeLength() const;
+
+    private:
+        Depth depth = Depth::None;
+
+        // Quantized colors the terminal is set to
+        CellColor current;
+
+        // Last color appended and its quantized form
+        CellColor lastColor, lastQuantized;
+
+        char *appendChange(char *out, const CellColor &quantized);
+    };
+}
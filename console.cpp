@@ -1,40 +1,132 @@
-#include "console.h"
-
-void Console::disableBuffering()
-{
-    // Disable buffering
-    setvbuf(stdout, NULL, _IONBF, 0);
-}
-
-void Console::fastwrite(const wchar_t *text, Color color)
-{
-    // Convert to UTF-8
-    std::wstring wstr(text);
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    std::string utf8Str = converter.to_bytes(wstr);
-
-    // Set the color
-    char colorCode[8];
-    snprintf(colorCode, sizeof(colorCode), "%s%d%s", "\033[", color, "m");
-    write(STDOUT_FILENO, colorCode, sizeof(colorCode));
-
-    // Write
-    write(STDOUT_FILENO, utf8Str.c_str(), utf8Str.size());
-
-    // Reset the color
-    const char* resetColor = "\033[0m";
-    write(STDOUT_FILENO, resetColor, sizeof(resetColor));
-}
-
-void Console::clear()
-{
-    // Clear the console
-    const char *clearScreen = "\033[2J\033[H";
-    write(STDOUT_FILENO, clearScreen, 7);
-}
-
-void Console::hideCursor() {
-    // Hide the cursor
-    const char *hideCursor = "\033[?25l";
-    write(STDOUT_FILENO, hideCursor, 6);
-}
+#include "console.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+
+namespace
+{
+    const char CLEAR_SCREEN[] = "\033[2J\033[H";
+    const char RESET_COLOR[] = "\033[0m";
+
+    // Parts handed to a single writev call
+    const int MAX_PARTS = 16;
+}
+
+void Console::disableBuffering()
+{
+    // Disable buffering
+    setvbuf(stdout, NULL, _IONBF, 0);
+}
+
+void Console::fastwrite(const char *text, size_t size, Color color)
+{
+    // Set the color, write (the text is already UTF-8) and reset the color in one go
+    char colorCode[8];
+    int colorCodeLength = formatColor(colorCode, color);
+
+    iovec parts[3] = {
+        {colorCode, static_cast<size_t>(colorCodeLength)},
+        {const_cast<char *>(text), size},
+        {const_cast<char *>(RESET_COLOR), sizeof(RESET_COLOR) - 1}};
+    writeParts(parts, 3);
+}
+
+color::Depth Console::detectColorDepth()
+{
+    const char *colorTerm = getenv("COLORTERM");
+    if (colorTerm && (strcmp(colorTerm, "truecolor") == 0 || strcmp(colorTerm, "24bit") == 0))
+        return color::Depth::TrueColor;
+
+    const char *term = getenv("TERM");
+    if (!term || !*term || strcmp(term, "dumb") == 0)
+        return color::Depth::None;
+
+    return strstr(term, "256color") ? color::Depth::Ansi256 : color::Depth::Ansi16;
+}
+
+bool Console::writeParts(const iovec *parts, int count, int fd)
+{
+    iovec pending[MAX_PARTS];
+
+    while (count > 0)
+    {
+        int batch = std::min(count, MAX_PARTS);
+        std::copy(parts, parts + batch, pending);
+
+        iovec *current = pending;
+        int remaining = batch;
+
+        while (remaining > 0)
+        {
+            ssize_t written = writev(fd, current, remaining);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                // Non-blocking output: wait until the terminal can take more
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    pollfd pfd = {fd, POLLOUT, 0};
+                    poll(&pfd, 1, -1);
+                    continue;
+                }
+
+                return false;
+            }
+
+            // Skip the parts that were fully written and advance into the partially written one
+            size_t left = static_cast<size_t>(written);
+            while (remaining > 0 && left >= current->iov_len)
+            {
+                left -= current->iov_len;
+                ++current;
+                --remaining;
+            }
+
+            if (remaining > 0)
+            {
+                current->iov_base = static_cast<char *>(current->iov_base) + left;
+                current->iov_len -= left;
+            }
+        }
+
+        parts += batch;
+        count -= batch;
+    }
+
+    return true;
+}
+
+int Console::formatColor(char *out, Color color)
+{
+    // Color is always two digits
+    return snprintf(out, 8, "%s%d%s", "\033[", color, "m");
+}
+
+int Console::formatClear(char *out)
+{
+    std::memcpy(out, CLEAR_SCREEN, sizeof(CLEAR_SCREEN) - 1);
+    return sizeof(CLEAR_SCREEN) - 1;
+}
+
+int Console::formatReset(char *out)
+{
+    std::memcpy(out, RESET_COLOR, sizeof(RESET_COLOR) - 1);
+    return sizeof(RESET_COLOR) - 1;
+}
+
+void Console::clear()
+{
+    // Clear the console
+    write(STDOUT_FILENO, CLEAR_SCREEN, sizeof(CLEAR_SCREEN) - 1);
+}
+
+void Console::hideCursor() {
+    // Hide the cursor
+    const char *hideCursor = "\033[?25l";
+    write(STDOUT_FILENO, hideCursor, 6);
+}
@@ -1,26 +1,39 @@
-#pragma once
-
-#include <string>
-#include <unistd.h>
-#include <codecvt>
-#include <locale>
-
-enum Color : int {
-    Black = 30,
-    Red = 31,
-    Green = 32,
-    Yellow = 33,
-    Blue = 34,
-    Magenta = 35,
-    Cyan = 36,
-    White = 37
-};
-
-class Console
-{
-public:
-    static void disableBuffering();
-    static void fastwrite(const wchar_t *text, Color color = Color::White);
-    static void clear();
-    static void hideCursor();
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "color.h"
+
+enum Color : int {
+    Black = 30,
+    Red = 31,
+    Green = 32,
+    Yellow = 33,
+    Blue = 34,
+    Magenta = 35,
+    Cyan = 36,
+    White = 37
+};
+
+class Console
+{
+public:
+    static void disableBuffering();
+    static void fastwrite(const char *text, size_t size, Color color = Color::White);
+
+    // Colors the terminal supports, from COLORTERM and TERM
+    static color::Depth detectColorDepth();
+
+    // Write all parts in order with writev, resuming after partial writes (false on error)
+    static bool writeParts(const iovec *parts, int count, int fd = STDOUT_FILENO);
+
+    // Escape sequences, written to out; each returns its length
+    static int formatColor(char *out, Color color);
+    static int formatClear(char *out);
+    static int formatReset(char *out);
+    static void clear();
+    static void hideCursor();
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "framebuffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+namespace
+{
+    const int ALIGNMENT = 64;
+}
+
+Glyph GlyphPalette::add(wchar_t character)
+{
+    for (int i = 0; i < count; ++i)
+        if (characters[i] == character)
+            return static_cast<Glyph>(i);
+
+    if (count == CAPACITY)
+        return 0;
+
+    characters[count] = character;
+    sequences[count] = utf8::encode(character);
+    return static_cast<Glyph>(count++);
+}
+
+Framebuffer::Framebuffer(int width, int height, int planes)
+    : width(width), height(height), planes(planes)
+{
+    // Pad rows to a whole number of cache lines of the narrowest plane
+    stride = (width + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    size_t cells = static_cast<size_t>(stride) * height;
+    size_t glyphBytes = (planes & GLYPH) ? cells * sizeof(Glyph) : 0;
+    size_t colorBytes = (planes & COLOR) ? cells * sizeof(color::CellColor) : 0;
+    size_t depthBytes = (planes & DEPTH) ? cells * sizeof(float) : 0;
+
+    // Every plane size is a multiple of the stride, so each plane stays aligned
+    if (posix_memalign(&memory, ALIGNMENT, std::max<size_t>(1, glyphBytes + colorBytes + depthBytes)) != 0)
+        throw std::bad_alloc();
+
+    char *base = static_cast<char *>(memory);
+    if (planes & GLYPH)
+        glyphs = reinterpret_cast<Glyph *>(base);
+    if (planes & COLOR)
+        colors = reinterpret_cast<color::CellColor *>(base + glyphBytes);
+    if (planes & DEPTH)
+        depths = reinterpret_cast<float *>(base + glyphBytes + colorBytes);
+
+    clear(0);
+}
+
+Framebuffer::~Framebuffer()
+{
+    free(memory);
+}
+
+void Framebuffer::clear(Glyph background)
+{
+    size_t cells = static_cast<size_t>(stride) * height;
+
+    if (glyphs)
+        std::fill(glyphs, glyphs + cells, background);
+    if (colors)
+        std::fill(colors, colors + cells, color::CellColor());
+    if (depths)
+        std::fill(depths, depths + cells, std::numeric_limits<float>::infinity());
+}
+
+void Framebuffer::copyGlyphs(const Framebuffer &other)
+{
+    std::copy(other.glyphs, other.glyphs + static_cast<size_t>(stride) * height, glyphs);
+}
+
+void Framebuffer::copyColors(const Framebuffer &other)
+{
+    std::copy(other.colors, other.colors + static_cast<size_t>(stride) * height, colors);
+}
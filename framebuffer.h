@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "utf8.h"
+
+// Glyph index of a cell, resolved to a character through a GlyphPalette
+typedef uint8_t Glyph;
+
+// Maps glyph indices to characters and their precomputed UTF-8 sequences
+class GlyphPalette
+{
+public:
+    static const int CAPACITY = 256;
+
+    // Index of the character, adding it if needed (returns 0 when the palette is full)
+    Glyph add(wchar_t character);
+
+    inline wchar_t getCharacter(Glyph glyph) const
+    {
+        return characters[glyph];
+    }
+    inline const utf8::Sequence &getSequence(Glyph glyph) const
+    {
+        return sequences[glyph];
+    }
+    inline int getCount() const
+    {
+        return count;
+    }
+
+    // Append the glyph to out and return the end of the written bytes. Always stores four
+    // bytes, so the destination needs three bytes of slack past its end.
+    inline char *append(char *out, Glyph glyph) const
+    {
+        const utf8::Sequence &sequence = sequences[glyph];
+        std::memcpy(out, sequence.bytes, 4);
+        return out + sequence.length;
+    }
+
+private:
+    wchar_t characters[CAPACITY] = {};
+    utf8::Sequence sequences[CAPACITY] = {};
+    int count = 0;
+};
+
+// Row-major cell planes in a single 64-byte aligned allocation. Rows are padded to a
+// common stride (in cells) so every row of every plane starts on a cache line.
+class Framebuffer
+{
+public:
+    enum Planes : int
+    {
+        GLYPH = 1,
+        COLOR = 2,
+        DEPTH = 4
+    };
+
+    Framebuffer(int width, int height, int planes = GLYPH | DEPTH);
+    ~Framebuffer();
+
+    Framebuffer(const Framebuffer &) = delete;
+    Framebuffer &operator=(const Framebuffer &) = delete;
+
+    // Fill the glyph plane with background, the color plane with the terminal's default
+    // colors and the depth plane with infinity
+    void clear(Glyph background);
+
+    // Copy the glyph or color plane of another framebuffer of the same size
+    void copyGlyphs(const Framebuffer &other);
+    void copyColors(const Framebuffer &other);
+
+    inline int getWidth() const
+    {
+        return width;
+    }
+    inline int getHeight() const
+    {
+        return height;
+    }
+    inline int getStride() const
+    {
+        return stride;
+    }
+
+    inline Glyph *glyphRow(int y)
+    {
+        return glyphs + y * stride;
+    }
+    inline const Glyph *glyphRow(int y) const
+    {
+        return glyphs + y * stride;
+    }
+    inline color::CellColor *colorRow(int y)
+    {
+        return colors + y * stride;
+    }
+    inline const color::CellColor *colorRow(int y) const
+    {
+        return colors + y * stride;
+    }
+    inline float *depthRow(int y)
+    {
+        return depths + y * stride;
+    }
+
+    inline bool hasPlane(Planes plane) const
+    {
+        return (planes & plane) != 0;
+    }
+
+private:
+    int width, height, stride, planes;
+
+    void *memory = nullptr;
+    Glyph *glyphs = nullptr;
+    color::CellColor *colors = nullptr;
+    float *depths = nullptr;
+};
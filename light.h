@@ -1,28 +1,86 @@
-#pragma once
-
-#include "math.h"
-
-struct Light
-{
-    fVec3 position;
-    float intensity;
-
-    static float calculateLightIntensity(const fVec3 &normal, const fVec3 &lightDir)
-    {
-        float intensity = std::max(0.f, normal.dot(lightDir));
-        return intensity;
-    }
-
-    static wchar_t getShade(float intensity)
-    {
-        // Convert the intensity to a shade character
-        if (intensity < 0.25f)
-            return 0x2591; // Light Shade
-        else if (intensity < 0.5f)
-            return 0x2592; // Medium Shade
-        else if (intensity < 0.75f)
-            return 0x2593; // Dark Shade
-        else
-            return 0x2588; // Full Block
-    }
-};
+#pragma once
+
+#include <algorithm>
+
+#include "math.h"
+
+enum class LightType
+{
+    Directional, // Lights everything from one direction
+    Point        // Lights from a position, fading with distance
+};
+
+struct Light
+{
+    LightType type = LightType::Directional;
+
+    // World-space position of a point light
+    fVec3 position;
+
+    // Direction towards a directional light (normalized when the light is added)
+    fVec3 direction = fVec3(0, 0, 1);
+
+    float intensity = 1.f;
+
+    // Point lights: intensity / (1 + attenuation * distance^2)
+    float attenuation = 0.f;
+
+    static Light directional(fVec3 direction, float intensity = 1.f)
+    {
+        Light light;
+        light.direction = direction;
+        light.intensity = intensity;
+        return light;
+    }
+
+    static Light point(fVec3 position, float intensity = 1.f, float attenuation = 0.f)
+    {
+        Light light;
+        light.type = LightType::Point;
+        light.position = position;
+        light.intensity = intensity;
+        light.attenuation = attenuation;
+        return light;
+    }
+
+    // Unit vector towards the light from a world position, scaled by the intensity reaching it
+    fVec3 getLightVector(const fVec3 &at) const
+    {
+        if (type == LightType::Directional)
+            return direction * intensity;
+
+        fVec3 toLight = position - at;
+        float distance = toLight.length();
+        if (distance == 0.f)
+            return fVec3();
+
+        return toLight * (intensity / (distance * (1.f + attenuation * distance * distance)));
+    }
+
+    static float calculateLightIntensity(const fVec3 &normal, const fVec3 &lightDir)
+    {
+        float intensity = std::max(0.f, normal.dot(lightDir));
+        return intensity;
+    }
+
+    // Number of shade characters, evenly spaced over the intensity range
+    static const int SHADE_LEVELS = 4;
+
+    static wchar_t getShadeLevel(int level)
+    {
+        static const wchar_t shades[SHADE_LEVELS] = {
+            0x2591, // Light Shade
+            0x2592, // Medium Shade
+            0x2593, // Dark Shade
+            0x2588  // Full Block
+        };
+        return shades[level];
+    }
+
+    static wchar_t getShade(float intensity)
+    {
+        // Convert the intensity to a shade character
+        intensity = std::max(0.f, std::min(intensity, 1.f));
+        return getShadeLevel(std::min(static_cast<int>(intensity * SHADE_LEVELS), SHADE_LEVELS - 1));
+    }
+};
@@ -1,32 +1,150 @@
-#include <iostream>
-#include <chrono>
-
-#include "renderer.h"
-#include "primitives.h"
-#include "mesh.h"
-#include "light.h"
-
-int main()
-{
-    Renderer renderer(50, 50);
-
-    renderer.createProjectionMatrix(45.f, .01f, 1000.f);
-    renderer.createViewMatrix(0.f, 0.f, 5.f);
-
-    Cube cubePrimitive;
-    Cube cubePrimitive2;
-
-    Mesh cubeMesh(cubePrimitive.getVertices(), cubePrimitive.getIndices(), cubePrimitive.getIndicesCount(), cubePrimitive.getVerticesCount());
-    
-    for (;;)
-    {
-        renderer.begin();
-
-        cubeMesh.setRotation({1, 1, 1});
-        renderer.draw(cubeMesh);
-
-        renderer.render();
-    }
-
-    return 0;
-}
\ No newline at end of file
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+#include "renderer.h"
+#include "primitives.h"
+#include "mesh.h"
+#include "meshio.h"
+#include "light.h"
+
+namespace
+{
+    bool endsWith(const char *text, const char *suffix)
+    {
+        size_t length = strlen(text), suffixLength = strlen(suffix);
+        return length >= suffixLength && strcmp(text + length - suffixLength, suffix) == 0;
+    }
+
+    // Import an OBJ or PLY model by extension
+    bool importModel(const char *path, MeshData &data)
+    {
+        if (endsWith(path, ".obj"))
+            return loadOBJ(path, data);
+        if (endsWith(path, ".ply"))
+            return loadPLY(path, data);
+
+        std::cerr << "Unknown model format: " << path << std::endl;
+        return false;
+    }
+
+    // Scale and center a mesh so its bounds fit in the unit cube, like the built-in primitives
+    void fitToUnitCube(Mesh &mesh)
+    {
+        const Vertex *vertices = mesh.getVertices();
+        if (mesh.getVerticesCount() == 0)
+            return;
+
+        fVec3 low = vertices[0].position, high = vertices[0].position;
+        for (int i = 1; i < mesh.getVerticesCount(); ++i)
+        {
+            const fVec3 &p = vertices[i].position;
+            low = fVec3(std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z));
+            high = fVec3(std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z));
+        }
+
+        float extent = std::max(high.x - low.x, std::max(high.y - low.y, high.z - low.z));
+        float factor = extent > 0 ? 2.f / extent : 1.f;
+
+        mesh.setScale(fVec3(factor, factor, factor));
+        mesh.setPosition((low + high) * (-.5f * factor));
+    }
+}
+
+// Usage: ascii_renderer [--half-block | --braille] [model.obj | model.ply | model.mesh]
+//        ascii_renderer --convert model.obj|model.ply model.mesh
+int main(int argc, char **argv)
+{
+    // Convert a text model into the binary mesh format
+    if (argc == 4 && strcmp(argv[1], "--convert") == 0)
+    {
+        MeshData data;
+        if (!importModel(argv[2], data))
+            return 1;
+
+        if (!MeshFile::write(argv[3], data.vertices.data(), static_cast<int>(data.vertices.size()),
+                             data.indices.data(), static_cast<int>(data.indices.size())))
+        {
+            std::cerr << "Cannot write " << argv[3] << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // Sub-cell output: more, smaller pixels packed into block or braille characters
+    CellMode cellMode = CellMode::Shaded;
+    if (argc >= 2 && strcmp(argv[1], "--half-block") == 0)
+        cellMode = CellMode::HalfBlock;
+    else if (argc >= 2 && strcmp(argv[1], "--braille") == 0)
+        cellMode = CellMode::Braille;
+
+    if (cellMode != CellMode::Shaded)
+    {
+        --argc;
+        ++argv;
+    }
+
+    // Load the model before taking over the terminal, so errors stay readable
+    Cube cubePrimitive;
+    MeshData data;
+    MeshFile file;
+
+    Mesh *mesh;
+
+    if (argc < 2)
+        mesh = new Mesh(cubePrimitive.getVertices(), cubePrimitive.getIndices(), cubePrimitive.getIndicesCount(), cubePrimitive.getVerticesCount(), MeshMemory::Borrowed);
+    else if (endsWith(argv[1], ".mesh"))
+    {
+        // Used straight from the mapping, nothing is parsed or copied (the indices are still
+        // checked, as the file may come from anywhere)
+        if (!file.open(argv[1]) || !file.validateIndices())
+        {
+            std::cerr << "Cannot open mesh file " << argv[1] << std::endl;
+            return 1;
+        }
+
+        mesh = new Mesh(file.getVertices(), file.getIndices(), file.getIndicesCount(), file.getVerticesCount(), MeshMemory::Borrowed);
+    }
+    else
+    {
+        if (!importModel(argv[1], data))
+        {
+            std::cerr << "Cannot import " << argv[1] << std::endl;
+            return 1;
+        }
+
+        mesh = new Mesh(data.vertices.data(), data.indices.data(), static_cast<int>(data.indices.size()), static_cast<int>(data.vertices.size()), MeshMemory::Borrowed);
+    }
+
+    if (argc >= 2)
+        fitToUnitCube(*mesh);
+
+    Renderer renderer(50, 50, RenderTarget::Console, cellMode);
+
+    renderer.createProjectionMatrix(45.f, .01f, 1000.f);
+    renderer.createViewMatrix(0.f, 0.f, 5.f);
+
+    // Color the mesh if the terminal can show it
+    renderer.setColorDepth(Console::detectColorDepth());
+    renderer.setColor(color::rgb(255, 176, 64));
+
+    // Present on a separate thread so a slow terminal does not stall rendering
+    renderer.setAsyncPresent(true);
+
+    for (;;)
+    {
+        renderer.begin();
+
+        // Spin around the world origin, where fitToUnitCube centers loaded models (their
+        // position is only the offset that gets them there)
+        mesh->setRotation(fVec3(0, 0, 0), {1, 1, 1});
+        renderer.draw(*mesh);
+
+        renderer.render();
+    }
+
+    delete mesh;
+
+    return 0;
+}
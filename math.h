@@ -1,399 +1,683 @@
-#pragma once
-
-#include <cmath>
-
-template <typename T>
-struct Vec2
-{
-    T x, y;
-
-    Vec2() : x(0), y(0) {}
-    Vec2(T x, T y) : x(x), y(y) {}
-
-    // Normalize the vector
-    Vec2 normalize() const
-    {
-        float length = std::sqrt(x * x + y * y);
-        return {x / length, y / length};
-    }
-
-    // Calculate the distance between two vectors
-    float distance(Vec2 v) const
-    {
-        return std::sqrt((x - v.x) * (x - v.x) + (y - v.y) * (y - v.y));
-    }
-
-    // Calculate the length of the vector
-    float length() const
-    {
-        return std::sqrt(x * x + y * y);
-    }
-
-    // Calculate the dot product of two vectors
-    float dot(Vec2 v) const
-    {
-        return x * v.x + y * v.y;
-    }
-
-    // Compare two vectors
-    bool operator==(const Vec2 v)
-    {
-        return x == v.x && y == v.y;
-    }
-
-    // Compare two vectors
-    bool operator!=(const Vec2 v)
-    {
-        return x != v.x || y != v.y;
-    }
-
-    // Add two vectors
-    Vec2 operator+(Vec2 v)
-    {
-        return Vec2(x + v.x, y + v.y);
-    }
-
-    // Substract two vectors
-    Vec2 operator-(Vec2 v)
-    {
-        return Vec2(x - v.x, y - v.y);
-    }
-
-    // Multiply a vector by a scalar
-    Vec2 operator*(T scalar)
-    {
-        return Vec2(x * scalar, y * scalar);
-    }
-
-    // Multiply two vectors
-    Vec2 operator*(Vec2 v)
-    {
-        return Vec2(x * v.x, y * v.y);
-    }
-
-    // Divide the vector by a scalar
-    Vec2 operator/(T scalar)
-    {
-        return Vec2(x / scalar, y / scalar);
-    }
-
-    // Add to the vector
-    Vec2 operator+=(Vec2 v)
-    {
-        x += v.x;
-        y += v.y;
-        return *this;
-    }
-
-    // Substract from the vector
-    Vec2 operator-=(Vec2 v)
-    {
-        x -= v.x;
-        y -= v.y;
-        return *this;
-    }
-
-    // Multiply the vector by a scalar
-    Vec2 operator*=(Vec2 v)
-    {
-        x *= v.x;
-        y *= v.y;
-        return *this;
-    }
-};
-typedef Vec2<int> iVec2;
-typedef Vec2<float> fVec2;
-
-namespace math
-{
-    // Convert degrees to radians
-    inline float toRadians(float degrees)
-    {
-        return degrees * M_PI / 180.f;
-    }
-
-    // Convert radians to degrees
-    inline float toDegrees(float radians)
-    {
-        return radians * 180.f / M_PI;
-    }
-
-    // Calculate the area of a triangle
-    inline float triArea(const iVec2 &v0, const iVec2 &v1, const iVec2 &v2)
-    {
-        return std::fabs((v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y)) / 2.0f;
-    }
-
-    // Check if a point is inside a triangle (edge function)
-    inline bool edgeFunction(const iVec2 &a, const iVec2 &b, const iVec2 &c)
-    {
-        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) >= 0;
-    }
-}
-
-template <typename T>
-struct Vec3
-{
-    T x, y, z;
-
-    Vec3() : x(0), y(0), z(0) {}
-    Vec3(T x, T y, T z) : x(x), y(y), z(z) {}
-
-    // Rotate the Vector around origin
-    Vec3 rotate(Vec3 origin, Vec3 euler)
-    {
-        // Translate the point to the origin (subtract origin)
-        x -= origin.x;
-        y -= origin.y;
-        z -= origin.z;
-
-        // Convert Euler angles (in degrees) to radians
-        float radsX = math::toRadians(euler.x);
-        float radsY = math::toRadians(euler.y);
-        float radsZ = math::toRadians(euler.z);
-
-        // Rotation around X axis
-        T ny = y * cos(radsX) - z * sin(radsX);
-        T nz = y * sin(radsX) + z * cos(radsX);
-        y = ny;
-        z = nz;
-
-        // Rotation around Y axis
-        T nx = x * cos(radsY) + z * sin(radsY);
-        nz = -x * sin(radsY) + z * cos(radsY);
-        x = nx;
-        z = nz;
-
-        // Rotation around Z axis
-        nx = x * cos(radsZ) - y * sin(radsZ);
-        ny = x * sin(radsZ) + y * cos(radsZ);
-        x = nx;
-        y = ny;
-
-        // Translate the point back to its original position (add origin)
-        x += origin.x;
-        y += origin.y;
-        z += origin.z;
-
-        return *this;
-    }
-
-    // Normalize the vector
-    Vec3 normalize() const
-    {
-        float length = std::sqrt(x * x + y * y + z * z);
-        return {x / length, y / length, z / length};
-    }
-
-    // Calculate the distance between two vectors
-    float distance(Vec3 v) const
-    {
-        return std::sqrt((x - v.x) * (x - v.x) + (y - v.y) * (y - v.y) + (z - v.z) * (z - v.z));
-    }
-
-    // Calculate the length of the vector
-    float length() const
-    {
-        return std::sqrt(x * x + y * y + z * z);
-    }
-
-    // Calculate the dot product of two vectors
-    float dot(Vec3 v) const
-    {
-        return x * v.x + y * v.y + z * v.z;
-    }
-
-    // Compare two vectors
-    bool operator==(const Vec3 v)
-    {
-        return x == v.x && y == v.y && z == v.z;
-    }
-
-    // Compare two vectors
-    bool operator!=(const Vec3 v)
-    {
-        return x != v.x || y != v.y || z != v.z;
-    }
-
-    // Add two vectors
-    Vec3 operator+(Vec3 v)
-    {
-        return Vec3(x + v.x, y + v.y, z + v.z);
-    }
-
-    // Substract two vectors
-    Vec3 operator-(Vec3 v)
-    {
-        return Vec3(x - v.x, y - v.y, z - v.z);
-    }
-
-    // Multiply a vector by a scalar
-    Vec3 operator*(T scalar)
-    {
-        return Vec3(x * scalar, y * scalar, z * scalar);
-    }
-
-    // Multiply two vectors
-    Vec3 operator*(Vec3 v)
-    {
-        return Vec3(x * v.x, y * v.y, z * v.z);
-    }
-
-    // Divide the vector by a scalar
-    Vec3 operator/(T scalar)
-    {
-        return Vec3(x / scalar, y / scalar, z / scalar);
-    }
-
-    // Add to the vector
-    Vec3 operator+=(Vec3 v)
-    {
-        x += v.x;
-        y += v.y;
-        z += v.z;
-        return *this;
-    }
-
-    // Substract from the vector
-    Vec3 operator-=(Vec3 v)
-    {
-        x -= v.x;
-        y -= v.y;
-        z -= v.z;
-        return *this;
-    }
-
-    // Multiply the vector by a scalar
-    Vec3 operator*=(Vec3 v)
-    {
-        x *= v.x;
-        y *= v.y;
-        z *= v.z;
-        return *this;
-    }
-};
-typedef Vec3<int> iVec3;
-typedef Vec3<float> fVec3;
-
-template <typename T>
-struct Mat
-{
-    int rows, cols;
-    T **data;
-
-    // Constructor
-    Mat(int rows, int cols)
-        : rows(rows), cols(cols)
-    {
-        // Allocate memory for the matrix
-        data = new T *[rows];
-        for (int i = 0; i < rows; ++i)
-            data[i] = new T[cols]();
-
-        // Fill the matrix with zeros
-        for (int i = 0; i < rows; ++i)
-            for (int j = 0; j < cols; ++j)
-                data[i][j] = 0;
-    }
-
-    // Copy constructor
-    Mat(const Mat &other) : rows(other.rows), cols(other.cols)
-    {
-        data = new T *[rows];
-        for (int i = 0; i < rows; ++i)
-        {
-            data[i] = new T[cols];
-            for (int j = 0; j < cols; ++j)
-            {
-                data[i][j] = other.data[i][j];
-            }
-        }
-    }
-
-    ~Mat()
-    {
-        // Free memory
-        for (int i = 0; i < rows; ++i)
-        {
-            delete[] data[i];
-        }
-
-        delete[] data;
-    }
-
-    // Create an identity matrix
-    static Mat identity(int size)
-    {
-        Mat result(size, size);
-
-        for (int i = 0; i < size; ++i)
-            result.data[i][i] = 1;
-
-        return result;
-    }
-
-    // Access the matrix element
-    T *operator[](const int i) const
-    {
-        return data[i];
-    }
-
-    // Multiply two matrices
-    Mat operator*(const Mat &m) const
-    {
-        if (cols != m.rows)
-            return Mat(0, 0);
-
-        Mat result(rows, m.cols);
-
-        for (int i = 0; i < rows; ++i)
-            for (int j = 0; j < m.cols; ++j)
-                for (int k = 0; k < cols; ++k)
-                    result.data[i][j] += data[i][k] * m.data[k][j];
-
-        return result;
-    }
-
-    // Multiply the matrix by a scalar
-    Mat operator*(const T scalar)
-    {
-        Mat result(rows, cols);
-
-        for (int i = 0; i < rows * cols; ++i)
-            result.data[i] = data[i] * scalar;
-
-        return result;
-    }
-
-    // Add two matrices
-    Mat operator+(const Mat &m) const
-    {
-        if (rows != m.rows || cols != m.cols)
-            return Mat(0, 0);
-
-        Mat result(rows, cols);
-
-        for (int i = 0; i < rows; ++i)
-            for (int j = 0; j < cols; ++j)
-                result.data[i][j] = data[i][j] + m.data[i][j];
-
-        return result;
-    }
-
-    // Substract two matrices
-    const Mat operator-(const Mat &m) const
-    {
-        if (rows != m.rows || cols != m.cols)
-            return Mat(0, 0);
-
-        Mat result(rows, cols);
-
-        for (int i = 0; i < rows; ++i)
-            for (int j = 0; j < cols; ++j)
-                result.data[i][j] = data[i][j] - m.data[i][j];
-
-        return result;
-    }
-};
-typedef Mat<int> iMat;
-typedef Mat<float> fMat;
\ No newline at end of file
+#pragma once
+
+#include <cmath>
+
+template <typename T>
+struct Vec2
+{
+    T x, y;
+
+    Vec2() : x(0), y(0) {}
+    Vec2(T x, T y) : x(x), y(y) {}
+
+    // Normalize the vector
+    Vec2 normalize() const
+    {
+        float length = std::sqrt(x * x + y * y);
+        return {x / length, y / length};
+    }
+
+    // Calculate the distance between two vectors
+    float distance(Vec2 v) const
+    {
+        return std::sqrt((x - v.x) * (x - v.x) + (y - v.y) * (y - v.y));
+    }
+
+    // Calculate the length of the vector
+    float length() const
+    {
+        return std::sqrt(x * x + y * y);
+    }
+
+    // Calculate the dot product of two vectors
+    float dot(Vec2 v) const
+    {
+        return x * v.x + y * v.y;
+    }
+
+    // Compare two vectors
+    bool operator==(const Vec2 v) const
+    {
+        return x == v.x && y == v.y;
+    }
+
+    // Compare two vectors
+    bool operator!=(const Vec2 v) const
+    {
+        return x != v.x || y != v.y;
+    }
+
+    // Add two vectors
+    Vec2 operator+(Vec2 v) const
+    {
+        return Vec2(x + v.x, y + v.y);
+    }
+
+    // Substract two vectors
+    Vec2 operator-(Vec2 v) const
+    {
+        return Vec2(x - v.x, y - v.y);
+    }
+
+    // Multiply a vector by a scalar
+    Vec2 operator*(T scalar) const
+    {
+        return Vec2(x * scalar, y * scalar);
+    }
+
+    // Multiply two vectors
+    Vec2 operator*(Vec2 v) const
+    {
+        return Vec2(x * v.x, y * v.y);
+    }
+
+    // Divide the vector by a scalar
+    Vec2 operator/(T scalar) const
+    {
+        return Vec2(x / scalar, y / scalar);
+    }
+
+    // Add to the vector
+    Vec2 operator+=(Vec2 v)
+    {
+        x += v.x;
+        y += v.y;
+        return *this;
+    }
+
+    // Substract from the vector
+    Vec2 operator-=(Vec2 v)
+    {
+        x -= v.x;
+        y -= v.y;
+        return *this;
+    }
+
+    // Multiply the vector by a scalar
+    Vec2 operator*=(Vec2 v)
+    {
+        x *= v.x;
+        y *= v.y;
+        return *this;
+    }
+};
+typedef Vec2<int> iVec2;
+typedef Vec2<float> fVec2;
+
+namespace math
+{
+    // Convert degrees to radians
+    inline float toRadians(float degrees)
+    {
+        return degrees * M_PI / 180.f;
+    }
+
+    // Convert radians to degrees
+    inline float toDegrees(float radians)
+    {
+        return radians * 180.f / M_PI;
+    }
+
+    // Calculate the area of a triangle
+    inline float triArea(const iVec2 &v0, const iVec2 &v1, const iVec2 &v2)
+    {
+        return std::fabs((v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y)) / 2.0f;
+    }
+
+    // Check if a point is inside a triangle (edge function)
+    inline bool edgeFunction(const iVec2 &a, const iVec2 &b, const iVec2 &c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) >= 0;
+    }
+}
+
+template <typename T>
+struct Vec3
+{
+    T x, y, z;
+
+    constexpr Vec3() : x(0), y(0), z(0) {}
+    constexpr Vec3(T x, T y, T z) : x(x), y(y), z(z) {}
+
+    // Rotate the Vector around origin
+    Vec3 rotate(Vec3 origin, Vec3 euler)
+    {
+        // Translate the point to the origin (subtract origin)
+        x -= origin.x;
+        y -= origin.y;
+        z -= origin.z;
+
+        // Convert Euler angles (in degrees) to radians
+        float radsX = math::toRadians(euler.x);
+        float radsY = math::toRadians(euler.y);
+        float radsZ = math::toRadians(euler.z);
+
+        // Rotation around X axis
+        T ny = y * cos(radsX) - z * sin(radsX);
+        T nz = y * sin(radsX) + z * cos(radsX);
+        y = ny;
+        z = nz;
+
+        // Rotation around Y axis
+        T nx = x * cos(radsY) + z * sin(radsY);
+        nz = -x * sin(radsY) + z * cos(radsY);
+        x = nx;
+        z = nz;
+
+        // Rotation around Z axis
+        nx = x * cos(radsZ) - y * sin(radsZ);
+        ny = x * sin(radsZ) + y * cos(radsZ);
+        x = nx;
+        y = ny;
+
+        // Translate the point back to its original position (add origin)
+        x += origin.x;
+        y += origin.y;
+        z += origin.z;
+
+        return *this;
+    }
+
+    // Normalize the vector
+    Vec3 normalize() const
+    {
+        float length = std::sqrt(x * x + y * y + z * z);
+        return {x / length, y / length, z / length};
+    }
+
+    // Calculate the distance between two vectors
+    float distance(Vec3 v) const
+    {
+        return std::sqrt((x - v.x) * (x - v.x) + (y - v.y) * (y - v.y) + (z - v.z) * (z - v.z));
+    }
+
+    // Calculate the length of the vector
+    float length() const
+    {
+        return std::sqrt(x * x + y * y + z * z);
+    }
+
+    // Calculate the dot product of two vectors
+    float dot(Vec3 v) const
+    {
+        return x * v.x + y * v.y + z * v.z;
+    }
+
+    // Compare two vectors
+    bool operator==(const Vec3 v) const
+    {
+        return x == v.x && y == v.y && z == v.z;
+    }
+
+    // Compare two vectors
+    bool operator!=(const Vec3 v) const
+    {
+        return x != v.x || y != v.y || z != v.z;
+    }
+
+    // Add two vectors
+    Vec3 operator+(Vec3 v) const
+    {
+        return Vec3(x + v.x, y + v.y, z + v.z);
+    }
+
+    // Substract two vectors
+    Vec3 operator-(Vec3 v) const
+    {
+        return Vec3(x - v.x, y - v.y, z - v.z);
+    }
+
+    // Multiply a vector by a scalar
+    Vec3 operator*(T scalar) const
+    {
+        return Vec3(x * scalar, y * scalar, z * scalar);
+    }
+
+    // Multiply two vectors
+    Vec3 operator*(Vec3 v) const
+    {
+        return Vec3(x * v.x, y * v.y, z * v.z);
+    }
+
+    // Divide the vector by a scalar
+    Vec3 operator/(T scalar) const
+    {
+        return Vec3(x / scalar, y / scalar, z / scalar);
+    }
+
+    // Add to the vector
+    Vec3 operator+=(Vec3 v)
+    {
+        x += v.x;
+        y += v.y;
+        z += v.z;
+        return *this;
+    }
+
+    // Substract from the vector
+    Vec3 operator-=(Vec3 v)
+    {
+        x -= v.x;
+        y -= v.y;
+        z -= v.z;
+        return *this;
+    }
+
+    // Multiply the vector by a scalar
+    Vec3 operator*=(Vec3 v)
+    {
+        x *= v.x;
+        y *= v.y;
+        z *= v.z;
+        return *this;
+    }
+};
+typedef Vec3<int> iVec3;
+typedef Vec3<float> fVec3;
+
+namespace math
+{
+    // Calculate the z component of the cross product of two 2D vectors (twice the signed area they span)
+    template <typename T>
+    inline T cross(const Vec2<T> &a, const Vec2<T> &b)
+    {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    // Calculate the cross product of two vectors
+    template <typename T>
+    inline Vec3<T> cross(const Vec3<T> &a, const Vec3<T> &b)
+    {
+        return Vec3<T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+}
+
+template <typename T>
+struct Mat
+{
+    int rows, cols;
+    T **data;
+
+    // Constructor
+    Mat(int rows, int cols)
+        : rows(rows), cols(cols)
+    {
+        // Allocate memory for the matrix
+        data = new T *[rows];
+        for (int i = 0; i < rows; ++i)
+            data[i] = new T[cols]();
+
+        // Fill the matrix with zeros
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                data[i][j] = 0;
+    }
+
+    // Copy constructor
+    Mat(const Mat &other) : rows(other.rows), cols(other.cols)
+    {
+        data = new T *[rows];
+        for (int i = 0; i < rows; ++i)
+        {
+            data[i] = new T[cols];
+            for (int j = 0; j < cols; ++j)
+            {
+                data[i][j] = other.data[i][j];
+            }
+        }
+    }
+
+    ~Mat()
+    {
+        // Free memory
+        for (int i = 0; i < rows; ++i)
+        {
+            delete[] data[i];
+        }
+
+        delete[] data;
+    }
+
+    // Create an identity matrix
+    static Mat identity(int size)
+    {
+        Mat result(size, size);
+
+        for (int i = 0; i < size; ++i)
+            result.data[i][i] = 1;
+
+        return result;
+    }
+
+    // Access the matrix element
+    T *operator[](const int i) const
+    {
+        return data[i];
+    }
+
+    // Multiply two matrices
+    Mat operator*(const Mat &m) const
+    {
+        if (cols != m.rows)
+            return Mat(0, 0);
+
+        Mat result(rows, m.cols);
+
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < m.cols; ++j)
+                for (int k = 0; k < cols; ++k)
+                    result.data[i][j] += data[i][k] * m.data[k][j];
+
+        return result;
+    }
+
+    // Multiply the matrix by a scalar
+    Mat operator*(const T scalar)
+    {
+        Mat result(rows, cols);
+
+        for (int i = 0; i < rows * cols; ++i)
+            result.data[i] = data[i] * scalar;
+
+        return result;
+    }
+
+    // Add two matrices
+    Mat operator+(const Mat &m) const
+    {
+        if (rows != m.rows || cols != m.cols)
+            return Mat(0, 0);
+
+        Mat result(rows, cols);
+
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                result.data[i][j] = data[i][j] + m.data[i][j];
+
+        return result;
+    }
+
+    // Substract two matrices
+    const Mat operator-(const Mat &m) const
+    {
+        if (rows != m.rows || cols != m.cols)
+            return Mat(0, 0);
+
+        Mat result(rows, cols);
+
+        for (int i = 0; i < rows; ++i)
+            for (int j = 0; j < cols; ++j)
+                result.data[i][j] = data[i][j] - m.data[i][j];
+
+        return result;
+    }
+};
+typedef Mat<int> iMat;
+typedef Mat<float> fMat;
+
+template <typename T>
+struct Vec4
+{
+    T x, y, z, w;
+
+    constexpr Vec4() : x(0), y(0), z(0), w(0) {}
+    constexpr Vec4(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+    constexpr Vec4(const Vec3<T> &v, T w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    // Drop the w component
+    constexpr Vec3<T> xyz() const
+    {
+        return Vec3<T>(x, y, z);
+    }
+
+    // Calculate the dot product of two vectors
+    constexpr T dot(const Vec4 &v) const
+    {
+        return x * v.x + y * v.y + z * v.z + w * v.w;
+    }
+
+    // Add two vectors
+    constexpr Vec4 operator+(const Vec4 &v) const
+    {
+        return Vec4(x + v.x, y + v.y, z + v.z, w + v.w);
+    }
+
+    // Substract two vectors
+    constexpr Vec4 operator-(const Vec4 &v) const
+    {
+        return Vec4(x - v.x, y - v.y, z - v.z, w - v.w);
+    }
+
+    // Multiply a vector by a scalar
+    constexpr Vec4 operator*(T scalar) const
+    {
+        return Vec4(x * scalar, y * scalar, z * scalar, w * scalar);
+    }
+};
+typedef Vec4<float> fVec4;
+
+// Fixed-size 4x4 matrix stored by value, row-major, for column vectors
+template <typename T>
+struct Mat4
+{
+    T data[4][4];
+
+    // Constructor (zero matrix)
+    constexpr Mat4() : data{} {}
+
+    // Create an identity matrix
+    static constexpr Mat4 identity()
+    {
+        Mat4 result;
+
+        for (int i = 0; i < 4; ++i)
+            result.data[i][i] = 1;
+
+        return result;
+    }
+
+    // Create a translation matrix
+    static constexpr Mat4 translation(const Vec3<T> &offset)
+    {
+        Mat4 result = identity();
+
+        result.data[0][3] = offset.x;
+        result.data[1][3] = offset.y;
+        result.data[2][3] = offset.z;
+
+        return result;
+    }
+
+    // Create a scaling matrix
+    static constexpr Mat4 scaling(const Vec3<T> &factors)
+    {
+        Mat4 result;
+
+        result.data[0][0] = factors.x;
+        result.data[1][1] = factors.y;
+        result.data[2][2] = factors.z;
+        result.data[3][3] = 1;
+
+        return result;
+    }
+
+    // Create a rotation matrix from Euler angles in degrees, applied around X, then Y, then Z
+    // (the same rotation as Vec3::rotate)
+    static Mat4 rotation(const Vec3<T> &euler)
+    {
+        T sx = std::sin(math::toRadians(euler.x)), cx = std::cos(math::toRadians(euler.x));
+        T sy = std::sin(math::toRadians(euler.y)), cy = std::cos(math::toRadians(euler.y));
+        T sz = std::sin(math::toRadians(euler.z)), cz = std::cos(math::toRadians(euler.z));
+
+        Mat4 result = identity();
+
+        result.data[0][0] = cz * cy;
+        result.data[0][1] = cz * sy * sx - sz * cx;
+        result.data[0][2] = cz * sy * cx + sz * sx;
+        result.data[1][0] = sz * cy;
+        result.data[1][1] = sz * sy * sx + cz * cx;
+        result.data[1][2] = sz * sy * cx - cz * sx;
+        result.data[2][0] = -sy;
+        result.data[2][1] = cy * sx;
+        result.data[2][2] = cy * cx;
+
+        return result;
+    }
+
+    // Create a perspective projection matrix (fov in radians)
+    static Mat4 perspective(T fov, T aspect, T near, T far)
+    {
+        T scale = 1 / std::tan(fov * T(.5));
+
+        Mat4 result;
+
+        result.data[0][0] = scale / aspect;
+        result.data[1][1] = scale;
+        result.data[2][2] = (far + near) / (near - far);
+        result.data[2][3] = (2 * far * near) / (near - far);
+        result.data[3][2] = -1;
+
+        return result;
+    }
+
+    // Create a view matrix looking from eye towards target
+    static Mat4 lookAt(Vec3<T> eye, Vec3<T> target, Vec3<T> up)
+    {
+        Vec3<T> forward = (target - eye).normalize();
+        Vec3<T> right = math::cross(forward, up).normalize();
+        Vec3<T> trueUp = math::cross(right, forward);
+
+        Mat4 result = identity();
+
+        result.data[0][0] = right.x;
+        result.data[0][1] = right.y;
+        result.data[0][2] = right.z;
+        result.data[0][3] = -right.dot(eye);
+        result.data[1][0] = trueUp.x;
+        result.data[1][1] = trueUp.y;
+        result.data[1][2] = trueUp.z;
+        result.data[1][3] = -trueUp.dot(eye);
+        result.data[2][0] = -forward.x;
+        result.data[2][1] = -forward.y;
+        result.data[2][2] = -forward.z;
+        result.data[2][3] = forward.dot(eye);
+
+        return result;
+    }
+
+    // Access the matrix element
+    constexpr T *operator[](const int i)
+    {
+        return data[i];
+    }
+    constexpr const T *operator[](const int i) const
+    {
+        return data[i];
+    }
+
+    // Multiply two matrices
+    constexpr Mat4 operator*(const Mat4 &m) const
+    {
+        Mat4 result;
+
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                result.data[i][j] = data[i][0] * m.data[0][j] +
+                                    data[i][1] * m.data[1][j] +
+                                    data[i][2] * m.data[2][j] +
+                                    data[i][3] * m.data[3][j];
+
+        return result;
+    }
+
+    // Transform a vector
+    constexpr Vec4<T> operator*(const Vec4<T> &v) const
+    {
+        return Vec4<T>(data[0][0] * v.x + data[0][1] * v.y + data[0][2] * v.z + data[0][3] * v.w,
+                       data[1][0] * v.x + data[1][1] * v.y + data[1][2] * v.z + data[1][3] * v.w,
+                       data[2][0] * v.x + data[2][1] * v.y + data[2][2] * v.z + data[2][3] * v.w,
+                       data[3][0] * v.x + data[3][1] * v.y + data[3][2] * v.z + data[3][3] * v.w);
+    }
+
+    // Rotation part of the matrix made orthonormal again (Gram-Schmidt over the columns of the
+    // upper 3x3 block, dropping the rest), so a rotation composed from many products does not
+    // pick up scale or shear
+    Mat4 orthonormalized() const
+    {
+        Vec3<T> x = Vec3<T>(data[0][0], data[1][0], data[2][0]).normalize();
+        Vec3<T> y(data[0][1], data[1][1], data[2][1]);
+        y = (y - x * x.dot(y)).normalize();
+        Vec3<T> z = math::cross(x, y);
+
+        Mat4 result = identity();
+        result.data[0][0] = x.x, result.data[1][0] = x.y, result.data[2][0] = x.z;
+        result.data[0][1] = y.x, result.data[1][1] = y.y, result.data[2][1] = y.z;
+        result.data[0][2] = z.x, result.data[1][2] = z.y, result.data[2][2] = z.z;
+
+        return result;
+    }
+
+    // Transpose the matrix
+    constexpr Mat4 transpose() const
+    {
+        Mat4 result;
+
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                result.data[i][j] = data[j][i];
+
+        return result;
+    }
+
+    // Invert the matrix (returns the zero matrix if it is singular)
+    constexpr Mat4 inverse() const
+    {
+        const T(&a)[4][4] = data;
+
+        // 2x2 sub-determinants of the upper and lower halves
+        T s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+        T s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+        T s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+        T s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+        T s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+        T s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+        T c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+        T c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+        T c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+        T c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+        T c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+        T c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+        T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+        Mat4 result;
+        if (det == 0)
+            return result;
+
+        T invDet = 1 / det;
+
+        result.data[0][0] = (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * invDet;
+        result.data[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * invDet;
+        result.data[0][2] = (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * invDet;
+        result.data[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * invDet;
+
+        result.data[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * invDet;
+        result.data[1][1] = (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * invDet;
+        result.data[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * invDet;
+        result.data[1][3] = (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * invDet;
+
+        result.data[2][0] = (a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * invDet;
+        result.data[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * invDet;
+        result.data[2][2] = (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * invDet;
+        result.data[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * invDet;
+
+        result.data[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * invDet;
+        result.data[3][1] = (a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * invDet;
+        result.data[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * invDet;
+        result.data[3][3] = (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * invDet;
+
+        return result;
+    }
+};
+typedef Mat4<float> fMat4;
\ No newline at end of file
@@ -1,92 +1,194 @@
-#pragma once
-
-#include "vertex.h"
-#include "primitives.h"
-#include "math.h"
-
-class Mesh
-{
-public:
-    // Constructors
-    Mesh(Vertex *vertices, int *indices, int indicesCount, int verticesCount) : vertices(vertices), indices(indices), verticesCount(verticesCount), indicesCount(indicesCount), position(0, 0, 0), rotation(0, 0, 0), scale(1, 1, 1) {}
-    Mesh(Vertex *vertices, int *indices, int indicesCount, int verticesCount, fVec3 position, fVec3 rotation, fVec3 scale)
-        : vertices(vertices), indices(indices), verticesCount(verticesCount), indicesCount(indicesCount), position(position), rotation(rotation), scale(scale) {}
-
-    // Setters
-    inline void setPosition(fVec3 position)
-    {
-        this->position = position;
-        for (int i = 0; i < verticesCount; ++i)
-        {
-            vertices[i].position += position;
-        }
-    }
-    inline void setRotation(fVec3 angles)
-    {
-        this->rotation += angles;
-        for (int i = 0; i < verticesCount; ++i)
-        {
-            // Rotate the vertex position and normals around the center of the mesh
-            vertices[i].position = vertices[i].position.rotate(position, angles);
-            vertices[i].normals = vertices[i].normals.rotate(position, angles);
-        }
-    }
-    inline void setRotation(fVec3 origin, fVec3 angles)
-    {
-        this->rotation += angles;
-        for (int i = 0; i < verticesCount; ++i)
-        {
-            // Rotate the vertex position and normals around user-defined origin
-            vertices[i].position = vertices[i].position.rotate(origin, angles);
-            vertices[i].normals = vertices[i].normals.rotate(origin, angles);
-        }
-    }
-    inline void setScale(fVec3 scale)
-    {
-        this->scale = scale;
-        for (int i = 0; i < verticesCount; ++i)
-        {
-            vertices[i].position *= scale;
-        }
-    }
-
-    // Getters
-    inline fVec3 getPosition() const
-    {
-        return position;
-    }
-    inline fVec3 getRotation() const
-    {
-        return rotation;
-    }
-    inline fVec3 getScale() const
-    {
-        return scale;
-    }
-
-    inline Vertex *getVertices()
-    {
-        return vertices;
-    }
-    inline int *getIndices()
-    {
-        return indices;
-    }
-    inline int getIndicesCount()
-    {
-        return indicesCount;
-    }
-
-    virtual ~Mesh()
-    {
-        delete[] vertices;
-        delete[] indices;
-    }
-
-private:
-    fVec3 position, rotation, scale;
-
-    Vertex *vertices = nullptr;
-    int *indices = nullptr;
-    int verticesCount = 0, indicesCount = 0;
+#pragma once
+
+#include "vertex.h"
+#include "primitives.h"
+#include "math.h"
+#include "vertexbuffer.h"
+#include "bounds.h"
+
+// Whether a mesh frees its arrays with delete[] (Owned) or only references memory that is
+// kept alive elsewhere, such as a primitive or a mapped mesh file (Borrowed)
+enum class MeshMemory
+{
+    Owned,
+    Borrowed
+};
+
+class Mesh
+{
+public:
+    // Constructors
+    Mesh(const Vertex *vertices, const int *indices, int indicesCount, int verticesCount, MeshMemory memory = MeshMemory::Owned) : position(0, 0, 0), rotation(0, 0, 0), scale(1, 1, 1), vertices(vertices), indices(indices), verticesCount(verticesCount), indicesCount(indicesCount), memory(memory)
+    {
+        computeBounds(vertices, verticesCount, localBox, localSphere);
+    }
+    Mesh(const Vertex *vertices, const int *indices, int indicesCount, int verticesCount, fVec3 position, fVec3 rotation, fVec3 scale, MeshMemory memory = MeshMemory::Owned)
+        : position(position), rotation(rotation), scale(scale), orientation(fMat4::rotation(rotation)), vertices(vertices), indices(indices), verticesCount(verticesCount), indicesCount(indicesCount), memory(memory)
+    {
+        computeBounds(vertices, verticesCount, localBox, localSphere);
+    }
+
+    // Mesh over structure-of-arrays vertices, transformed in batches by the renderer
+    Mesh(const VertexBuffer *vertexBuffer, const int *indices, int indicesCount, MeshMemory memory = MeshMemory::Owned) : position(0, 0, 0), rotation(0, 0, 0), scale(1, 1, 1), indices(indices), verticesCount(vertexBuffer->getCount()), indicesCount(indicesCount), vertexBuffer(vertexBuffer), memory(memory)
+    {
+        computeBounds(*vertexBuffer, localBox, localSphere);
+    }
+
+    Mesh(const Mesh &) = delete;
+    Mesh &operator=(const Mesh &) = delete;
+
+    // Setters (the vertex data is never modified, the transform is applied in the vertex stage)
+    inline void setPosition(fVec3 position)
+    {
+        this->position = position;
+        modelDirty = true;
+    }
+    inline void setRotation(fVec3 angles)
+    {
+        // Rotate around the center of the mesh
+        compose(fVec3(0, 0, 0), angles);
+    }
+    inline void setRotation(fVec3 origin, fVec3 angles)
+    {
+        // Rotate around user-defined origin
+        compose(origin - position, angles);
+    }
+    inline void setScale(fVec3 scale)
+    {
+        this->scale = scale;
+        modelDirty = true;
+    }
+
+    // Getters
+    inline fVec3 getPosition() const
+    {
+        return position;
+    }
+    inline fVec3 getRotation() const
+    {
+        return rotation;
+    }
+    inline fVec3 getScale() const
+    {
+        return scale;
+    }
+
+    // Model matrix (scale, then the accumulated rotations, then translation) and the
+    // matching normal matrix, rebuilt only after the transform changed
+    inline const fMat4 &getModelMatrix() const
+    {
+        updateModelMatrix();
+        return modelMatrix;
+    }
+    inline const fMat4 &getNormalMatrix() const
+    {
+        updateModelMatrix();
+        return normalMatrix;
+    }
+
+    // Bounds in object space, computed once from the vertices
+    inline const BoundingBox &getLocalBoundingBox() const
+    {
+        return localBox;
+    }
+    inline const BoundingSphere &getLocalBoundingSphere() const
+    {
+        return localSphere;
+    }
+
+    // Bounds with the mesh transform applied, updated along with the model matrix
+    inline const BoundingBox &getBoundingBox() const
+    {
+        updateModelMatrix();
+        return box;
+    }
+    inline const BoundingSphere &getBoundingSphere() const
+    {
+        updateModelMatrix();
+        return sphere;
+    }
+
+    // Interleaved vertices, or null if the mesh uses a vertex buffer
+    inline const Vertex *getVertices() const
+    {
+        return vertices;
+    }
+    inline const VertexBuffer *getVertexBuffer() const
+    {
+        return vertexBuffer;
+    }
+    inline const int *getIndices() const
+    {
+        return indices;
+    }
+    inline int getIndicesCount() const
+    {
+        return indicesCount;
+    }
+    inline int getVerticesCount() const
+    {
+        return verticesCount;
+    }
+
+    virtual ~Mesh()
+    {
+        if (memory == MeshMemory::Borrowed)
+            return;
+
+        delete[] vertices;
+        delete[] indices;
+        delete vertexBuffer;
+    }
+
+private:
+    fVec3 position, rotation, scale;
+
+    // Every rotation so far, composed in call order like the vertex rotations they replace,
+    // and the offset from the position that rotations about an origin moved the mesh by
+    fMat4 orientation = fMat4::identity();
+    fVec3 offset;
+
+    mutable fMat4 modelMatrix, normalMatrix;
+    mutable bool modelDirty = true;
+
+    BoundingBox localBox;
+    BoundingSphere localSphere;
+    mutable BoundingBox box;
+    mutable BoundingSphere sphere;
+
+    const Vertex *vertices = nullptr;
+    const int *indices = nullptr;
+    int verticesCount = 0, indicesCount = 0;
+    const VertexBuffer *vertexBuffer = nullptr;
+    MeshMemory memory;
+
+    // Rotate by angles around pivot (relative to the position): the orientation turns by the
+    // rotation and is re-orthonormalized, so rounding never builds up into scale or shear,
+    // and the offset swings around the pivot through the normalized result
+    inline void compose(fVec3 pivot, fVec3 angles)
+    {
+        fMat4 turn = fMat4::rotation(angles);
+        orientation = (turn * orientation).orthonormalized();
+
+        fVec4 swung = turn * fVec4(offset - pivot, 0.f);
+        offset = swung.xyz() + pivot;
+
+        rotation += angles;
+        modelDirty = true;
+    }
+
+    inline void updateModelMatrix() const
+    {
+        if (!modelDirty)
+            return;
+
+        modelMatrix = fMat4::translation(position + offset) * orientation * fMat4::scaling(scale);
+
+        // Normals transform by the inverse transpose, which keeps them perpendicular under non-uniform scale
+        normalMatrix = modelMatrix.inverse().transpose();
+
+        box = localBox.transformed(modelMatrix);
+        sphere = localSphere.transformed(modelMatrix);
+        modelDirty = false;
+    }
 };
\ No newline at end of file
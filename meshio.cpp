@@ -0,0 +1,665 @@
+#include "meshio.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The file stores vertices exactly as they are laid out in memory
+static_assert(sizeof(Vertex) == 6 * sizeof(float), "Vertex must be six packed floats");
+
+namespace
+{
+    const size_t ALIGNMENT = 64;
+
+    inline size_t alignUp(size_t value)
+    {
+        return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    bool readFile(const char *path, std::string &data)
+    {
+        FILE *file = fopen(path, "rb");
+        if (!file)
+            return false;
+
+        char buffer[65536];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            data.append(buffer, read);
+
+        bool ok = !ferror(file);
+        fclose(file);
+
+        return ok;
+    }
+
+    // Triangulate a polygon as a fan, reversing its winding to clockwise
+    void addPolygon(std::vector<int> &indices, const std::vector<int> &polygon)
+    {
+        for (size_t i = 1; i + 1 < polygon.size(); ++i)
+        {
+            indices.push_back(polygon[0]);
+            indices.push_back(polygon[i + 1]);
+            indices.push_back(polygon[i]);
+        }
+    }
+
+    // Smooth normals for the vertices flagged in missing, weighted by the area of the faces around them
+    void computeNormals(MeshData &mesh, const std::vector<bool> &missing)
+    {
+        std::vector<fVec3> sums(mesh.vertices.size());
+
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            int a = mesh.indices[i], b = mesh.indices[i + 1], c = mesh.indices[i + 2];
+            const fVec3 &p0 = mesh.vertices[a].position;
+            const fVec3 &p1 = mesh.vertices[b].position;
+            const fVec3 &p2 = mesh.vertices[c].position;
+
+            // Faces are clockwise, so this points out of the front face
+            fVec3 normal = math::cross(p2 - p0, p1 - p0);
+            sums[a] += normal;
+            sums[b] += normal;
+            sums[c] += normal;
+        }
+
+        for (size_t i = 0; i < mesh.vertices.size(); ++i)
+        {
+            if (!missing[i])
+                continue;
+
+            const fVec3 &sum = sums[i];
+            bool degenerate = sum.x == 0 && sum.y == 0 && sum.z == 0;
+            mesh.vertices[i].normals = degenerate ? fVec3(0, 0, 1) : sum.normalize();
+        }
+    }
+
+    // Exact bit pattern of a vertex, for merging identical vertices
+    struct VertexKey
+    {
+        uint32_t bits[6];
+
+        explicit VertexKey(const Vertex &vertex)
+        {
+            std::memcpy(bits, &vertex, sizeof(bits));
+        }
+        bool operator==(const VertexKey &other) const
+        {
+            return std::memcmp(bits, other.bits, sizeof(bits)) == 0;
+        }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey &key) const
+        {
+            // FNV-1a over the six words
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t word : key.bits)
+                hash = (hash ^ word) * 1099511628211ull;
+
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    // Parse an OBJ index (1-based, or negative relative to the end), -1 if it is out of range
+    int resolveIndex(long index, size_t count)
+    {
+        if (index > 0 && static_cast<size_t>(index) <= count)
+            return static_cast<int>(index - 1);
+        if (index < 0 && static_cast<size_t>(-index) <= count)
+            return static_cast<int>(count + index);
+
+        return -1;
+    }
+
+    // PLY scalar types
+    enum PlyType
+    {
+        PLY_INVALID,
+        PLY_INT8,
+        PLY_UINT8,
+        PLY_INT16,
+        PLY_UINT16,
+        PLY_INT32,
+        PLY_UINT32,
+        PLY_FLOAT32,
+        PLY_FLOAT64
+    };
+
+    PlyType parsePlyType(const std::string &name)
+    {
+        if (name == "char" || name == "int8")
+            return PLY_INT8;
+        if (name == "uchar" || name == "uint8")
+            return PLY_UINT8;
+        if (name == "short" || name == "int16")
+            return PLY_INT16;
+        if (name == "ushort" || name == "uint16")
+            return PLY_UINT16;
+        if (name == "int" || name == "int32")
+            return PLY_INT32;
+        if (name == "uint" || name == "uint32")
+            return PLY_UINT32;
+        if (name == "float" || name == "float32")
+            return PLY_FLOAT32;
+        if (name == "double" || name == "float64")
+            return PLY_FLOAT64;
+
+        return PLY_INVALID;
+    }
+
+    int getPlyTypeSize(PlyType type)
+    {
+        static const int sizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+        return sizes[type];
+    }
+
+    struct PlyProperty
+    {
+        std::string name;
+        PlyType type;
+        PlyType countType; // PLY_INVALID unless the property is a list
+    };
+
+    struct PlyElement
+    {
+        std::string name;
+        long count;
+        std::vector<PlyProperty> properties;
+    };
+
+    // Reads PLY values from the body, as text or in either byte order
+    class PlyReader
+    {
+    public:
+        enum Format
+        {
+            ASCII,
+            LITTLE_ENDIAN_BINARY,
+            BIG_ENDIAN_BINARY
+        };
+
+        PlyReader(const char *data, const char *end, Format format)
+            : data(data), end(end), format(format) {}
+
+        bool read(PlyType type, double &value)
+        {
+            if (format == ASCII)
+            {
+                while (data < end && (*data == ' ' || *data == '\t' || *data == '\r' || *data == '\n'))
+                    ++data;
+
+                // The body is not null-terminated, so parse from a bounded copy of the token
+                char token[64];
+                size_t length = 0;
+                while (data + length < end && length < sizeof(token) - 1 && !std::strchr(" \t\r\n", data[length]))
+                    ++length;
+                if (length == 0)
+                    return false;
+
+                std::memcpy(token, data, length);
+                token[length] = 0;
+
+                char *parsed;
+                value = std::strtod(token, &parsed);
+                data += length;
+
+                return parsed == token + length;
+            }
+
+            int size = getPlyTypeSize(type);
+            if (end - data < size)
+                return false;
+
+            unsigned char bytes[8];
+            std::memcpy(bytes, data, size);
+            data += size;
+
+            bool bigEndianHost = false;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            bigEndianHost = true;
+#endif
+            if ((format == BIG_ENDIAN_BINARY) != bigEndianHost)
+                for (int i = 0; i < size / 2; ++i)
+                    std::swap(bytes[i], bytes[size - 1 - i]);
+
+            switch (type)
+            {
+            case PLY_INT8:
+                value = static_cast<int8_t>(bytes[0]);
+                break;
+            case PLY_UINT8:
+                value = bytes[0];
+                break;
+            case PLY_INT16:
+                value = load<int16_t>(bytes);
+                break;
+            case PLY_UINT16:
+                value = load<uint16_t>(bytes);
+                break;
+            case PLY_INT32:
+                value = load<int32_t>(bytes);
+                break;
+            case PLY_UINT32:
+                value = load<uint32_t>(bytes);
+                break;
+            case PLY_FLOAT32:
+                value = load<float>(bytes);
+                break;
+            case PLY_FLOAT64:
+                value = load<double>(bytes);
+                break;
+            default:
+                return false;
+            }
+
+            return true;
+        }
+
+    private:
+        const char *data, *end;
+        Format format;
+
+        template <typename T>
+        static T load(const unsigned char *bytes)
+        {
+            T value;
+            std::memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+    };
+}
+
+bool loadOBJ(const char *path, MeshData &mesh)
+{
+    std::string data;
+    if (!readFile(path, data))
+        return false;
+
+    std::vector<fVec3> positions, normals;
+    std::unordered_map<uint64_t, int> vertexIndices;
+    std::vector<bool> missingNormals;
+    std::vector<int> polygon;
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+
+    // Parse line by line (the string is null-terminated, so strtof and strtol stop at its end)
+    const char *line = data.c_str();
+    while (*line)
+    {
+        const char *next = std::strchr(line, '\n');
+        const char *lineEnd = next ? next : line + std::strlen(line);
+
+        if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t'))
+        {
+            char *p;
+            float x = std::strtof(line + 2, &p);
+            float y = std::strtof(p, &p);
+            float z = std::strtof(p, &p);
+            positions.push_back(fVec3(x, y, z));
+        }
+        else if (line[0] == 'v' && line[1] == 'n' && (line[2] == ' ' || line[2] == '\t'))
+        {
+            char *p;
+            float x = std::strtof(line + 3, &p);
+            float y = std::strtof(p, &p);
+            float z = std::strtof(p, &p);
+            normals.push_back(fVec3(x, y, z));
+        }
+        else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'))
+        {
+            polygon.clear();
+            const char *p = line + 2;
+
+            // Vertices are v, v/vt, v//vn or v/vt/vn
+            for (;;)
+            {
+                while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r'))
+                    ++p;
+                if (p >= lineEnd)
+                    break;
+
+                char *end;
+                int position = resolveIndex(std::strtol(p, &end, 10), positions.size());
+                if (end == p || end > lineEnd || position < 0)
+                    return false;
+                p = end;
+
+                int normal = -1;
+                if (*p == '/')
+                {
+                    // Skip the texture coordinate
+                    ++p;
+                    if (*p != '/')
+                    {
+                        std::strtol(p, &end, 10);
+                        p = end;
+                    }
+                    if (*p == '/')
+                    {
+                        normal = resolveIndex(std::strtol(p + 1, &end, 10), normals.size());
+                        if (end == p + 1 || normal < 0)
+                            return false;
+                        p = end;
+                    }
+                }
+
+                // One vertex per distinct position/normal pair
+                uint64_t key = static_cast<uint64_t>(position) << 32 | static_cast<uint32_t>(normal + 1);
+                auto found = vertexIndices.find(key);
+                if (found == vertexIndices.end())
+                {
+                    Vertex vertex;
+                    vertex.position = positions[position];
+                    if (normal >= 0)
+                        vertex.normals = normals[normal];
+
+                    found = vertexIndices.emplace(key, static_cast<int>(mesh.vertices.size())).first;
+                    mesh.vertices.push_back(vertex);
+                    missingNormals.push_back(normal < 0);
+                }
+
+                polygon.push_back(found->second);
+            }
+
+            addPolygon(mesh.indices, polygon);
+        }
+
+        line = next ? next + 1 : lineEnd;
+    }
+
+    computeNormals(mesh, missingNormals);
+
+    return true;
+}
+
+bool loadPLY(const char *path, MeshData &mesh)
+{
+    std::string data;
+    if (!readFile(path, data))
+        return false;
+
+    if (data.compare(0, 4, "ply\n") != 0 && data.compare(0, 5, "ply\r\n") != 0)
+        return false;
+
+    // Parse the header one line at a time, up to the line that is exactly end_header (a
+    // comment may mention it too)
+    PlyReader::Format format = PlyReader::ASCII;
+    std::vector<PlyElement> elements;
+
+    size_t bodyStart = std::string::npos;
+    size_t position = data.find('\n') + 1;
+    for (;;)
+    {
+        size_t lineEnd = data.find('\n', position);
+        if (lineEnd == std::string::npos)
+            return false;
+
+        std::string line = data.substr(position, lineEnd - position);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        position = lineEnd + 1;
+
+        if (line == "end_header")
+        {
+            bodyStart = lineEnd;
+            break;
+        }
+
+        char word[32], type[32], countType[32], name[64];
+        long count;
+
+        if (std::sscanf(line.c_str(), "format %31s", word) == 1)
+        {
+            if (std::strcmp(word, "ascii") == 0)
+                format = PlyReader::ASCII;
+            else if (std::strcmp(word, "binary_little_endian") == 0)
+                format = PlyReader::LITTLE_ENDIAN_BINARY;
+            else if (std::strcmp(word, "binary_big_endian") == 0)
+                format = PlyReader::BIG_ENDIAN_BINARY;
+            else
+                return false;
+        }
+        else if (std::sscanf(line.c_str(), "element %63s %ld", name, &count) == 2)
+        {
+            if (count < 0 || count > INT_MAX)
+                return false;
+            elements.push_back({name, count, {}});
+        }
+        else if (std::sscanf(line.c_str(), "property list %31s %31s %63s", countType, type, name) == 3)
+        {
+            if (elements.empty())
+                return false;
+            elements.back().properties.push_back({name, parsePlyType(type), parsePlyType(countType)});
+        }
+        else if (std::sscanf(line.c_str(), "property %31s %63s", type, name) == 2)
+        {
+            if (elements.empty())
+                return false;
+            elements.back().properties.push_back({name, parsePlyType(type), PLY_INVALID});
+        }
+    }
+
+    for (const PlyElement &element : elements)
+        for (const PlyProperty &property : element.properties)
+            if (property.type == PLY_INVALID || (property.countType == PLY_INVALID && property.name == "vertex_indices"))
+                return false;
+
+    // Read the body
+    PlyReader reader(data.data() + bodyStart + 1, data.data() + data.size(), format);
+
+    std::vector<Vertex> plyVertices;
+    bool hasNormals = false;
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+
+    std::vector<int> polygon;
+
+    for (const PlyElement &element : elements)
+    {
+        bool isVertex = element.name == "vertex";
+        bool isFace = element.name == "face";
+
+        if (isVertex)
+        {
+            plyVertices.resize(element.count);
+            for (const PlyProperty &property : element.properties)
+                hasNormals = hasNormals || property.name == "nx";
+        }
+
+        for (long i = 0; i < element.count; ++i)
+        {
+            for (const PlyProperty &property : element.properties)
+            {
+                double value;
+
+                if (property.countType != PLY_INVALID)
+                {
+                    // List: a count, then that many items
+                    if (!reader.read(property.countType, value) || value < 0)
+                        return false;
+
+                    int count = static_cast<int>(value);
+                    bool isIndices = isFace && (property.name == "vertex_indices" || property.name == "vertex_index");
+                    polygon.clear();
+
+                    for (int j = 0; j < count; ++j)
+                    {
+                        if (!reader.read(property.type, value))
+                            return false;
+
+                        if (isIndices)
+                        {
+                            if (value < 0 || value >= static_cast<double>(plyVertices.size()))
+                                return false;
+                            polygon.push_back(static_cast<int>(value));
+                        }
+                    }
+
+                    if (isIndices)
+                        addPolygon(mesh.indices, polygon);
+
+                    continue;
+                }
+
+                if (!reader.read(property.type, value))
+                    return false;
+
+                if (!isVertex)
+                    continue;
+
+                Vertex &vertex = plyVertices[i];
+                float component = static_cast<float>(value);
+
+                if (property.name == "x")
+                    vertex.position.x = component;
+                else if (property.name == "y")
+                    vertex.position.y = component;
+                else if (property.name == "z")
+                    vertex.position.z = component;
+                else if (property.name == "nx")
+                    vertex.normals.x = component;
+                else if (property.name == "ny")
+                    vertex.normals.y = component;
+                else if (property.name == "nz")
+                    vertex.normals.z = component;
+            }
+        }
+    }
+
+    // Merge identical vertices and remap the faces
+    std::unordered_map<VertexKey, int, VertexKeyHash> vertexIndices;
+    std::vector<int> remap(plyVertices.size());
+
+    for (size_t i = 0; i < plyVertices.size(); ++i)
+    {
+        auto found = vertexIndices.emplace(VertexKey(plyVertices[i]), static_cast<int>(mesh.vertices.size()));
+        if (found.second)
+            mesh.vertices.push_back(plyVertices[i]);
+
+        remap[i] = found.first->second;
+    }
+
+    for (int &index : mesh.indices)
+        index = remap[index];
+
+    if (!hasNormals)
+        computeNormals(mesh, std::vector<bool>(mesh.vertices.size(), true));
+
+    return true;
+}
+
+MeshFile::~MeshFile()
+{
+    close();
+}
+
+bool MeshFile::open(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header)))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(status.st_size);
+    void *memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (memory == MAP_FAILED)
+        return false;
+
+    mapping = memory;
+    mappingSize = size;
+
+    // Check the header and that both sections lie inside the file
+    Header header;
+    std::memcpy(&header, mapping, sizeof(header));
+
+    bool valid = header.magic == MAGIC && header.version == VERSION &&
+                 header.verticesCount <= INT_MAX && header.indicesCount <= INT_MAX &&
+                 header.verticesOffset % ALIGNMENT == 0 && header.indicesOffset % ALIGNMENT == 0 &&
+                 header.verticesOffset <= size && (size - header.verticesOffset) / sizeof(Vertex) >= header.verticesCount &&
+                 header.indicesOffset <= size && (size - header.indicesOffset) / sizeof(int) >= header.indicesCount;
+
+    if (!valid)
+    {
+        close();
+        return false;
+    }
+
+    const char *base = static_cast<const char *>(mapping);
+    vertices = reinterpret_cast<const Vertex *>(base + header.verticesOffset);
+    indices = reinterpret_cast<const int *>(base + header.indicesOffset);
+    verticesCount = static_cast<int>(header.verticesCount);
+    indicesCount = static_cast<int>(header.indicesCount);
+
+    return true;
+}
+
+bool MeshFile::validateIndices() const
+{
+    // An index out of range would make the renderer read past the vertices
+    for (int i = 0; i < indicesCount; ++i)
+        if (indices[i] < 0 || indices[i] >= verticesCount)
+            return false;
+
+    return true;
+}
+
+void MeshFile::close()
+{
+    if (mapping)
+        munmap(mapping, mappingSize);
+
+    mapping = nullptr;
+    mappingSize = 0;
+    vertices = nullptr;
+    indices = nullptr;
+    verticesCount = indicesCount = 0;
+}
+
+bool MeshFile::write(const char *path, const Vertex *vertices, int verticesCount, const int *indices, int indicesCount)
+{
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.verticesCount = static_cast<uint32_t>(verticesCount);
+    header.indicesCount = static_cast<uint32_t>(indicesCount);
+    header.verticesOffset = alignUp(sizeof(Header));
+    header.indicesOffset = alignUp(header.verticesOffset + verticesCount * sizeof(Vertex));
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    static const char padding[ALIGNMENT] = {};
+    size_t vertexBytes = verticesCount * sizeof(Vertex);
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(padding, 1, header.verticesOffset - sizeof(header), file) == header.verticesOffset - sizeof(header) &&
+              fwrite(vertices, 1, vertexBytes, file) == vertexBytes &&
+              fwrite(padding, 1, header.indicesOffset - header.verticesOffset - vertexBytes, file) == header.indicesOffset - header.verticesOffset - vertexBytes &&
+              fwrite(indices, sizeof(int), indicesCount, file) == static_cast<size_t>(indicesCount);
+
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vertex.h"
+
+// Indexed geometry produced by the importers. Faces are triangulated and wound clockwise
+// like the built-in primitives (OBJ and PLY faces are counter-clockwise, so they are
+// reversed). Meshes without normals get smooth, area-weighted normals.
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<int> indices;
+};
+
+// Wavefront OBJ (v, vn and f records; other records are ignored). Each distinct
+// position/normal pair becomes one vertex. Returns false if the file cannot be read or is malformed.
+bool loadOBJ(const char *path, MeshData &mesh);
+
+// PLY in ascii, binary_little_endian or binary_big_endian, with x/y/z (and optionally nx/ny/nz)
+// vertex properties and a vertex_indices face list. Identical vertices are merged.
+// Returns false if the file cannot be read or is malformed.
+bool loadPLY(const char *path, MeshData &mesh);
+
+// Binary mesh file mapped into memory: a header followed by the vertices and indices in their
+// in-memory layout, each section aligned to 64 bytes, so the mapping is used as is.
+class MeshFile
+{
+public:
+    static const uint32_t MAGIC = 0x48534d41; // "AMSH"
+    static const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic, version;
+        uint32_t verticesCount, indicesCount;
+        uint64_t verticesOffset, indicesOffset;
+    };
+
+    MeshFile() = default;
+    ~MeshFile();
+
+    MeshFile(const MeshFile &) = delete;
+    MeshFile &operator=(const MeshFile &) = delete;
+
+    // Map a mesh file, checking only its header and section sizes so the geometry is not
+    // touched (false if it cannot be mapped or is not a valid mesh file)
+    bool open(const char *path);
+    void close();
+
+    // True if every index is in range. Reads the whole index section, so files from untrusted
+    // sources opt in to it once after open.
+    bool validateIndices() const;
+
+    // Write geometry in this format (false on error)
+    static bool write(const char *path, const Vertex *vertices, int verticesCount, const int *indices, int indicesCount);
+
+    // Valid while the file is open
+    inline const Vertex *getVertices() const
+    {
+        return vertices;
+    }
+    inline const int *getIndices() const
+    {
+        return indices;
+    }
+    inline int getVerticesCount() const
+    {
+        return verticesCount;
+    }
+    inline int getIndicesCount() const
+    {
+        return indicesCount;
+    }
+
+private:
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+
+    const Vertex *vertices = nullptr;
+    const int *indices = nullptr;
+    int verticesCount = 0, indicesCount = 0;
+};
@@ -0,0 +1,386 @@
+#include "presenter.h"
+
+namespace
+{
+    // Number of decimal digits of a positive number
+    inline int digitCount(int value)
+    {
+        int digits = 1;
+        while (value >= 10)
+        {
+            value /= 10;
+            ++digits;
+        }
+        return digits;
+    }
+
+    // Append a positive number in decimal
+    inline int appendNumber(char *out, int value)
+    {
+        int digits = digitCount(value);
+        for (int i = digits - 1; i >= 0; --i, value /= 10)
+            out[i] = '0' + value % 10;
+
+        return digits;
+    }
+
+    // Length of a cursor position escape sequence
+    inline int cursorPositionLength(int row, int col)
+    {
+        return 4 + digitCount(row) + digitCount(col);
+    }
+
+    // Append a cursor position escape sequence (1-based row and column)
+    inline int appendCursorPosition(char *out, int row, int col)
+    {
+        int length = 0;
+        out[length++] = '\033';
+        out[length++] = '[';
+        length += appendNumber(out + length, row);
+        out[length++] = ';';
+        length += appendNumber(out + length, col);
+        out[length++] = 'H';
+
+        return length;
+    }
+}
+
+Presenter::Presenter(int width, int height, const GlyphPalette &palette, int cellWidth)
+    : width(width), height(height), cellWidth(cellWidth), palette(palette),
+      presented(width, height, Framebuffer::GLYPH | Framebuffer::COLOR)
+{
+    // Allocate screen buffer (every cell cellWidth times, at most 4 UTF-8 bytes each, plus newlines,
+    // and room for a color escape before every cell and a background reset on every row)
+    screenCapacity = width * cellWidth * height * 4 + height + width * height * color::MAX_SGR_LENGTH + height * 5;
+    screen = new char[screenCapacity + 4]();
+}
+
+Presenter::~Presenter()
+{
+    delete[] screen;
+}
+
+void Presenter::setMode(PresentMode mode)
+{
+    this->mode = mode;
+    presentedValid = false;
+}
+void Presenter::invalidate()
+{
+    presentedValid = false;
+}
+void Presenter::setColorDepth(color::Depth depth)
+{
+    colors.setDepth(depth);
+    presentedValid = false;
+}
+void Presenter::setOutput(int fd)
+{
+    this->fd = fd;
+    sink = nullptr;
+    presentedValid = false;
+}
+void Presenter::setOutput(FrameSink sink)
+{
+    this->sink = std::move(sink);
+    presentedValid = false;
+}
+void Presenter::setProfiler(Profiler *profiler, bool overlay)
+{
+    this->profiler = profiler;
+    this->overlay = overlay;
+}
+void Presenter::present(const Framebuffer &frame, float fps)
+{
+    int length = -1, headerLength = 0, footerLength;
+
+    {
+        Profiler::Scope scope(profiler, Stage::Encode);
+
+        // Encode the framebuffer into the screen buffer
+        if (mode == PresentMode::Delta)
+            length = encodeDelta(frame);
+        if (length < 0)
+            length = encodeFull(frame, mode == PresentMode::Full);
+
+        // Clear the screen (Delta mode overwrites the previous frame in place instead),
+        // display the frames per second and set the color (unless every cell sets its own)
+        if (mode == PresentMode::Full)
+            headerLength += Console::formatClear(header);
+        headerLength += formatFPS(header + headerLength, fps);
+        if (!hasColors(frame))
+            headerLength += Console::formatColor(header + headerLength, Color::White);
+
+        footerLength = Console::formatReset(footer);
+    }
+
+    {
+        Profiler::Scope scope(profiler, Stage::Write);
+
+        // Present the whole frame with a single writev
+        iovec parts[3] = {
+            {header, static_cast<size_t>(headerLength)},
+            {screen, static_cast<size_t>(length)},
+            {footer, static_cast<size_t>(footerLength)}};
+
+        if (sink)
+            sink(parts, 3);
+        else
+            Console::writeParts(parts, 3, fd);
+    }
+
+    if (profiler)
+    {
+        profiler->commit(Stage::Encode);
+        profiler->commit(Stage::Write);
+    }
+}
+int Presenter::encodeFull(const Framebuffer &frame, bool trailingNewline)
+{
+    // The frame starts at the default colors the previous footer left the terminal in
+    bool colored = hasColors(frame);
+    colors.reset();
+
+    // Draw the framebuffer to the screen buffer
+    char *out = screen;
+    for (int y = 0; y < height; ++y)
+    {
+        const Glyph *row = frame.glyphRow(y);
+        const color::CellColor *colorRow = colored ? frame.colorRow(y) : nullptr;
+
+        int x = 0;
+        while (x < width)
+        {
+            // Switch colors once per run of cells sharing them
+            int end = width;
+            if (colored)
+            {
+                out = colors.append(out, colorRow[x]);
+                for (end = x + 1; end < width && colorRow[end] == colorRow[x]; ++end)
+                    ;
+            }
+
+            for (; x < end; ++x)
+                out = appendCell(out, row[x]);
+        }
+
+        if (colored)
+            out = colors.endRow(out);
+
+        // Without the last newline the terminal never scrolls, which Delta mode relies on
+        if (trailingNewline || y + 1 < height)
+            *out++ = '\n';
+    }
+
+    // Remember what the terminal shows now
+    if (mode == PresentMode::Delta)
+    {
+        presented.copyGlyphs(frame);
+        if (colored)
+            presented.copyColors(frame);
+        presentedValid = true;
+    }
+
+    return static_cast<int>(out - screen);
+}
+int Presenter::encodeDelta(const Framebuffer &frame)
+{
+    // Frame row y is terminal row y + 2 (the FPS line is row 1), cell x starts at column cellWidth * x + 1
+    if (!presentedValid)
+        return -1;
+
+    bool colored = hasColors(frame);
+    colors.reset();
+
+    // UTF-8 bytes a full redraw would cost, with an escape wherever the color changes
+    int fullBytes = height - 1;
+    for (int y = 0; y < height; ++y)
+    {
+        const Glyph *row = frame.glyphRow(y);
+        for (int x = 0; x < width; ++x)
+            fullBytes += cellWidth * palette.getSequence(row[x]).length;
+
+        if (colored)
+        {
+            const color::CellColor *colorRow = frame.colorRow(y);
+            for (int x = 1; x < width; ++x)
+                if (colorRow[x] != colorRow[x - 1])
+                    fullBytes += colors.getChangeLength();
+        }
+    }
+
+    int deltaBytes = 0;
+    char *out = screen;
+
+    for (int y = 0; y < height; ++y)
+    {
+        const Glyph *row = frame.glyphRow(y);
+        const Glyph *previous = presented.glyphRow(y);
+        const color::CellColor *colorRow = colored ? frame.colorRow(y) : nullptr;
+        const color::CellColor *previousColors = colored ? presented.colorRow(y) : nullptr;
+
+        // Most rows of a typical frame are unchanged
+        if (std::equal(row, row + width, previous) && (!colored || std::equal(colorRow, colorRow + width, previousColors)))
+            continue;
+
+        // A cell needs rewriting if its glyph or its color changed
+        auto changed = [&](int x)
+        {
+            return row[x] != previous[x] || (colored && colorRow[x] != previousColors[x]);
+        };
+
+        int x = 0;
+        while (x < width)
+        {
+            if (!changed(x))
+            {
+                ++x;
+                continue;
+            }
+
+            // Extend the run over changed cells, and over unchanged gaps cheaper to resend than to skip
+            int cursorCost = cursorPositionLength(y + 2, cellWidth * x + 1);
+            int end = x + 1;
+            int runBytes = cellWidth * palette.getSequence(row[x]).length;
+
+            while (end < width)
+            {
+                if (changed(end))
+                {
+                    runBytes += cellWidth * palette.getSequence(row[end]).length;
+                    ++end;
+                    continue;
+                }
+
+                int gapEnd = end, gapBytes = 0;
+                while (gapEnd < width && !changed(gapEnd) && gapBytes < cursorCost)
+                {
+                    gapBytes += cellWidth * palette.getSequence(row[gapEnd]).length;
+                    ++gapEnd;
+                }
+
+                if (gapEnd == width || gapBytes >= cursorCost)
+                    break;
+
+                runBytes += gapBytes;
+                end = gapEnd;
+            }
+
+            // Give up as soon as the delta is no cheaper than a full redraw (or would not fit,
+            // with an escape before every cell of the run)
+            deltaBytes += cursorCost + runBytes;
+            int escapeBytes = colored ? (end - x) * color::MAX_SGR_LENGTH : 0;
+            if (deltaBytes >= fullBytes || deltaBytes + escapeBytes > screenCapacity)
+                return -1;
+
+            out += appendCursorPosition(out, y + 2, cellWidth * x + 1);
+            for (; x < end; ++x)
+            {
+                // The color state carries over cursor moves, so runs of one color still share an escape
+                if (colored)
+                {
+                    char *escape = out;
+                    out = colors.append(out, colorRow[x]);
+                    deltaBytes += static_cast<int>(out - escape);
+                }
+
+                out = appendCell(out, row[x]);
+            }
+        }
+    }
+
+    // Remember what the terminal shows now
+    presented.copyGlyphs(frame);
+    if (colored)
+        presented.copyColors(frame);
+
+    return static_cast<int>(out - screen);
+}
+
+int Presenter::formatFPS(char *out, float fps)
+{
+    // Fits in the header next to the clear and color sequences
+    int length = snprintf(out, 40, "\033[HFPS: %d", static_cast<int>(fps));
+
+    // Profiler overlay on the same line, cut to the width of the frame so the line does not wrap
+    if (profiler && overlay)
+    {
+        // Columns left after the FPS counter (the cursor home sequence takes none) and the separator
+        int lineLength = width * cellWidth < OVERLAY_LENGTH ? width * cellWidth : OVERLAY_LENGTH;
+        int columns = lineLength - (length - 3) - 3;
+        if (columns > 0)
+        {
+            length += snprintf(out + length, 4, " | ");
+            length += profiler->formatOverlay(out + length, columns + 1);
+        }
+    }
+
+    return length + snprintf(out + length, 8, "\033[K\n");
+}
+
+AsyncPresenter::AsyncPresenter(Presenter &presenter, Framebuffer *frames[3])
+    : presenter(presenter), middle(1), waiting(false)
+{
+    for (int i = 0; i < 3; ++i)
+        slots[i].frame = frames[i];
+
+    thread = std::thread(&AsyncPresenter::presentLoop, this);
+}
+
+AsyncPresenter::~AsyncPresenter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+
+    thread.join();
+}
+
+Framebuffer *AsyncPresenter::publish(float fps)
+{
+    slots[back].fps = fps;
+
+    // Swap the finished frame into the middle slot; a frame still waiting there is dropped
+    int previous = middle.exchange(back | NEW_FRAME);
+    if (previous & NEW_FRAME)
+        ++droppedFrames;
+
+    back = previous & SLOT_MASK;
+
+    // Only a waiting present thread needs a wakeup. It sets waiting before checking middle,
+    // and both sides are sequentially consistent, so either it sees this frame or we see it
+    // waiting; the lock then keeps the wakeup from falling between its check and its wait.
+    if (waiting.load())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        wake.notify_one();
+    }
+
+    return slots[back].frame;
+}
+
+void AsyncPresenter::presentLoop()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            waiting.store(true);
+            wake.wait(lock, [this]
+                      { return stopping || (middle.load() & NEW_FRAME); });
+            waiting.store(false);
+
+            if (stopping)
+                return;
+        }
+
+        // Take the newest frame and hand the one we presented last back to the pool
+        front = middle.exchange(front, std::memory_order_acq_rel) & SLOT_MASK;
+
+        presenter.present(*slots[front].frame, slots[front].fps);
+    }
+}
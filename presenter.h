@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "console.h"
+#include "framebuffer.h"
+#include "profiler.h"
+
+// How a finished frame is sent to the terminal
+enum class PresentMode
+{
+    Full,  // Clear the console and rewrite every cell
+    Delta  // Only rewrite the cells that changed since the last presented frame
+};
+
+// Receives the encoded parts of a frame, to be written out in order
+typedef std::function<void(const iovec *parts, int count)> FrameSink;
+
+// Encodes finished frames to UTF-8 and writes them to the terminal
+class Presenter
+{
+public:
+    // Every cell is written cellWidth (1 or 2) times across, 2 making glyph cells roughly square
+    Presenter(int width, int height, const GlyphPalette &palette, int cellWidth = 2);
+    ~Presenter();
+
+    Presenter(const Presenter &) = delete;
+    Presenter &operator=(const Presenter &) = delete;
+
+    void setMode(PresentMode mode);
+    inline PresentMode getMode() const
+    {
+        return mode;
+    }
+
+    // Colors of the cells, quantized to what the terminal shows (None by default, which
+    // ignores the color plane and writes the whole frame in one color)
+    void setColorDepth(color::Depth depth);
+    inline color::Depth getColorDepth() const
+    {
+        return colors.getDepth();
+    }
+
+    // Write frames to a file descriptor (stdout by default) or hand them to a sink
+    void setOutput(int fd);
+    void setOutput(FrameSink sink);
+
+    // Time the encode and write stages with the profiler, optionally showing its
+    // statistics next to the FPS counter
+    void setProfiler(Profiler *profiler, bool overlay = false);
+
+    // Encode the glyph plane (and the color plane, if it has one) of the frame and write it
+    // with a single writev
+    void present(const Framebuffer &frame, float fps);
+
+    // The palette changed under the last presented frame, so the next one is written in full
+    void invalidate();
+
+private:
+    // Longest profiler overlay, in characters
+    static const int OVERLAY_LENGTH = 160;
+
+    int width, height, cellWidth;
+    const GlyphPalette &palette;
+
+    Profiler *profiler = nullptr;
+    bool overlay = false;
+
+    int fd = STDOUT_FILENO;
+    FrameSink sink;
+
+    // UTF-8 bytes of the next frame to write to the terminal, framed by a header
+    // (clear, FPS line and color) and a footer (color reset) in the same write. Color
+    // escapes are only written where the color changes.
+    char *screen;
+    char header[64 + OVERLAY_LENGTH], footer[8];
+    int screenCapacity;
+
+    // Color state of the terminal while encoding
+    color::Encoder colors;
+
+    // Glyphs and colors last sent to the terminal in Delta mode
+    Framebuffer presented;
+    bool presentedValid = false;
+    PresentMode mode = PresentMode::Full;
+
+    // True if the cells of the frame carry their own colors
+    inline bool hasColors(const Framebuffer &frame) const
+    {
+        return colors.getDepth() != color::Depth::None && frame.hasPlane(Framebuffer::COLOR);
+    }
+
+    // Append a cell to out, cellWidth times
+    inline char *appendCell(char *out, Glyph glyph) const
+    {
+        out = palette.append(out, glyph);
+        return cellWidth == 2 ? palette.append(out, glyph) : out;
+    }
+
+    int encodeFull(const Framebuffer &frame, bool trailingNewline);
+    int encodeDelta(const Framebuffer &frame);
+
+    int formatFPS(char *out, float fps);
+};
+
+// Runs a Presenter on its own thread, fed through a lock-free triple buffer. The renderer
+// draws into the back slot and publishes it; the present thread always takes the newest
+// published frame, so frames the terminal cannot keep up with are dropped, never queued.
+// Publishing only takes the mutex to wake the present thread when it is idle waiting for a
+// frame, never while it is busy presenting one.
+class AsyncPresenter
+{
+public:
+    // Slot 0 starts as the back buffer, slot 1 as the middle and slot 2 as the front
+    AsyncPresenter(Presenter &presenter, Framebuffer *frames[3]);
+    ~AsyncPresenter();
+
+    AsyncPresenter(const AsyncPresenter &) = delete;
+    AsyncPresenter &operator=(const AsyncPresenter &) = delete;
+
+    // Hand the back frame to the present thread and return the frame to draw next
+    Framebuffer *publish(float fps);
+
+    inline Framebuffer *getBackFrame() const
+    {
+        return slots[back].frame;
+    }
+
+    // Frames replaced before the present thread got to them
+    inline unsigned getDroppedFrames() const
+    {
+        return droppedFrames;
+    }
+
+private:
+    static const int SLOT_MASK = 3;
+    static const int NEW_FRAME = 4;
+
+    struct Slot
+    {
+        Framebuffer *frame;
+        float fps = 0.f;
+    };
+
+    Presenter &presenter;
+    Slot slots[3];
+
+    // Slot owned by the renderer, by the present thread, and the shared middle slot (plus NEW_FRAME)
+    int back = 0, front = 2;
+    std::atomic<int> middle;
+    unsigned droppedFrames = 0;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Set by the present thread before it checks for a frame and waits
+    std::atomic<bool> waiting;
+
+    void presentLoop();
+};
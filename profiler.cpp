@@ -0,0 +1,165 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+Profiler::Profiler()
+    : enabled(false), origin(now())
+{
+    events = new Event[TRACE_CAPACITY];
+}
+
+Profiler::~Profiler()
+{
+    delete[] events;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Start from an empty history when enabling, keep it for reading back when disabling
+    if (enabled && !isEnabled())
+    {
+        for (StageHistory &history : stages)
+        {
+            history.current = 0;
+            history.count = history.next = 0;
+        }
+        eventCount = nextEvent = 0;
+        origin = now();
+    }
+
+    this->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::add(Stage stage, int64_t start, int64_t end)
+{
+    int thread = getThreadId();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    stages[static_cast<int>(stage)].current += end - start;
+
+    // Overwrite the oldest span once the trace buffer is full
+    events[nextEvent] = {stage, thread, start, end - start};
+    nextEvent = (nextEvent + 1) % TRACE_CAPACITY;
+    if (eventCount < TRACE_CAPACITY)
+        ++eventCount;
+}
+
+void Profiler::commit(Stage stage)
+{
+    if (!isEnabled())
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    StageHistory &history = stages[static_cast<int>(stage)];
+    history.durations[history.next] = history.current;
+    history.next = (history.next + 1) % HISTORY;
+    if (history.count < HISTORY)
+        ++history.count;
+    history.current = 0;
+}
+
+Profiler::Stats Profiler::getStats(Stage stage) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return getStatsLocked(stage);
+}
+
+Profiler::Stats Profiler::getStatsLocked(Stage stage) const
+{
+    const StageHistory &history = stages[static_cast<int>(stage)];
+    Stats stats = {0.f, 0.f, 0.f, history.count};
+
+    if (history.count == 0)
+        return stats;
+
+    // Percentiles over a sorted copy of the history
+    int64_t sorted[HISTORY];
+    std::copy(history.durations, history.durations + history.count, sorted);
+    std::sort(sorted, sorted + history.count);
+
+    stats.p50 = sorted[(history.count - 1) / 2] / 1000.f;
+    stats.p99 = sorted[(history.count - 1) * 99 / 100] / 1000.f;
+    stats.max = sorted[history.count - 1] / 1000.f;
+
+    return stats;
+}
+
+bool Profiler::writeTrace(const char *path) const
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Complete events ("X") in microseconds, oldest first
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    int first = (nextEvent - eventCount + TRACE_CAPACITY) % TRACE_CAPACITY;
+    for (int i = 0; i < eventCount; ++i)
+    {
+        const Event &event = events[(first + i) % TRACE_CAPACITY];
+
+        fprintf(file, "{\"name\":\"%s\",\"cat\":\"pipeline\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}%s\n",
+                getStageName(event.stage), (event.start - origin) / 1000.0, event.duration / 1000.0,
+                event.thread, i + 1 < eventCount ? "," : "");
+    }
+
+    fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+
+    return fclose(file) == 0;
+}
+
+int Profiler::formatOverlay(char *out, int capacity) const
+{
+    if (capacity <= 0)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // "<stage> p50/p99" for every stage, in microseconds
+    int length = 0;
+    for (int i = 0; i < STAGE_COUNT && length < capacity - 1; ++i)
+    {
+        Stats stats = getStatsLocked(static_cast<Stage>(i));
+
+        length += snprintf(out + length, capacity - length, "%s%s %.0f/%.0f",
+                           i ? " " : "", getStageName(static_cast<Stage>(i)), stats.p50, stats.p99);
+    }
+    if (length < capacity - 1)
+        length += snprintf(out + length, capacity - length, " us");
+
+    return std::min(length, capacity - 1);
+}
+
+const char *Profiler::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+    case Stage::Clear:
+        return "clear";
+    case Stage::Vertex:
+        return "vertex";
+    case Stage::Raster:
+        return "raster";
+    case Stage::Encode:
+        return "encode";
+    case Stage::Write:
+        return "write";
+    default:
+        return "unknown";
+    }
+}
+
+int Profiler::getThreadId()
+{
+    static std::atomic<int> nextId(1);
+    thread_local int id = nextId++;
+
+    return id;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+// Pipeline stages timed by the profiler
+enum class Stage : int
+{
+    Clear,  // Clearing the framebuffer in begin()
+    Vertex, // Vertex stage of draw()
+    Raster, // Triangle setup, binning and shading
+    Encode, // Encoding the frame to UTF-8
+    Write,  // Writing the frame to the terminal or sink
+    Count
+};
+
+// Times the pipeline stages of every frame. Each stage keeps the total time it took in its
+// last HISTORY frames for percentiles, and every timed span is kept for a Chrome trace.
+// Stages may be timed from any thread.
+class Profiler
+{
+public:
+    static const int STAGE_COUNT = static_cast<int>(Stage::Count);
+    static const int HISTORY = 256;
+    static const int TRACE_CAPACITY = 8192;
+
+    // Statistics of a stage over the recorded frames, in microseconds
+    struct Stats
+    {
+        float p50, p99, max;
+        int frames;
+    };
+
+    // Times a stage from construction to destruction (nothing when the profiler is null or disabled)
+    class Scope
+    {
+    public:
+        Scope(Profiler *profiler, Stage stage)
+            : profiler(profiler && profiler->isEnabled() ? profiler : nullptr), stage(stage)
+        {
+            if (this->profiler)
+                start = now();
+        }
+        ~Scope()
+        {
+            if (profiler)
+                profiler->add(stage, start, now());
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Profiler *profiler;
+        Stage stage;
+        int64_t start = 0;
+    };
+
+    Profiler();
+    ~Profiler();
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    // Disabled by default; enabling starts from an empty history, disabling keeps it
+    void setEnabled(bool enabled);
+    inline bool isEnabled() const
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Add a span of the stage to its current frame
+    void add(Stage stage, int64_t start, int64_t end);
+
+    // Close the current frame of the stage, pushing its total time into the history
+    void commit(Stage stage);
+
+    Stats getStats(Stage stage) const;
+
+    // Write the recorded spans as Chrome trace-event JSON (false if the file cannot be written)
+    bool writeTrace(const char *path) const;
+
+    // One line with the p50/p99 of every stage, truncated to capacity - 1 characters
+    int formatOverlay(char *out, int capacity) const;
+
+    static const char *getStageName(Stage stage);
+
+    // Steady clock in nanoseconds
+    static inline int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    struct StageHistory
+    {
+        int64_t current = 0;
+        int64_t durations[HISTORY];
+        int count = 0, next = 0;
+    };
+
+    struct Event
+    {
+        Stage stage;
+        int thread;
+        int64_t start, duration;
+    };
+
+    std::atomic<bool> enabled;
+    int64_t origin;
+
+    mutable std::mutex mutex;
+    StageHistory stages[STAGE_COUNT];
+
+    Event *events;
+    int eventCount = 0, nextEvent = 0;
+
+    Stats getStatsLocked(Stage stage) const;
+
+    // Small per-thread id for the trace
+    static int getThreadId();
+};
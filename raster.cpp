@@ -0,0 +1,200 @@
+#include "raster.h"
+
+#include <algorithm>
+
+namespace
+{
+    struct FixedPoint
+    {
+        int64_t x, y;
+    };
+
+    // Top-left fill rule: cells exactly on an edge belong to it only if it is a top or left edge
+    inline bool isTopLeft(const FixedPoint &a, const FixedPoint &b)
+    {
+        int64_t dx = b.x - a.x;
+        int64_t dy = b.y - a.y;
+
+        return (dy == 0 && dx > 0) || dy < 0;
+    }
+
+    // Edge function of a -> b evaluated at p, positive on the inner side
+    inline int64_t edge(const FixedPoint &a, const FixedPoint &b, const FixedPoint &p)
+    {
+        return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+    }
+
+    // Largest magnitude an edge reaches over the bounding box (plus a full SIMD block of overshoot)
+    inline int64_t edgeRange(int64_t w, int64_t stepX, int64_t stepY, int columns, int rows)
+    {
+        int64_t x = std::abs(stepX) * (columns + 8);
+        int64_t y = std::abs(stepY) * rows;
+
+        return std::abs(w) + x + y;
+    }
+}
+
+bool raster::Triangle::setup(const fVec2 &v0, const fVec2 &v1, const fVec2 &v2, int width, int height)
+{
+    // Reject anything that would overflow the fixed-point range
+    if (std::fabs(v0.x) > GUARD_BAND || std::fabs(v0.y) > GUARD_BAND ||
+        std::fabs(v1.x) > GUARD_BAND || std::fabs(v1.y) > GUARD_BAND ||
+        std::fabs(v2.x) > GUARD_BAND || std::fabs(v2.y) > GUARD_BAND)
+        return false;
+
+    // Snap the vertices to the subpixel grid
+    FixedPoint p0 = {toFixed(v0.x), toFixed(v0.y)};
+    FixedPoint p1 = {toFixed(v1.x), toFixed(v1.y)};
+    FixedPoint p2 = {toFixed(v2.x), toFixed(v2.y)};
+
+    // Twice the signed area, non-positive for backfacing and degenerate triangles
+    int64_t area = edge(p0, p1, p2);
+    if (area <= 0)
+        return false;
+
+    // Bounding box, clamped to the target
+    minX = std::max(0, static_cast<int>(std::min({p0.x, p1.x, p2.x}) >> SUBPIXEL_BITS));
+    minY = std::max(0, static_cast<int>(std::min({p0.y, p1.y, p2.y}) >> SUBPIXEL_BITS));
+    maxX = std::min(width - 1, static_cast<int>(std::max({p0.x, p1.x, p2.x}) >> SUBPIXEL_BITS));
+    maxY = std::min(height - 1, static_cast<int>(std::max({p0.y, p1.y, p2.y}) >> SUBPIXEL_BITS));
+
+    if (minX > maxX || minY > maxY)
+        return false;
+
+    // Edge values at the first cell center, biased so that the inside test is always >= 0
+    FixedPoint origin = {(static_cast<int64_t>(minX) << SUBPIXEL_BITS) + SUBPIXEL_ONE / 2,
+                         (static_cast<int64_t>(minY) << SUBPIXEL_BITS) + SUBPIXEL_ONE / 2};
+
+    w0 = edge(p1, p2, origin) - (isTopLeft(p1, p2) ? 0 : 1);
+    w1 = edge(p2, p0, origin) - (isTopLeft(p2, p0) ? 0 : 1);
+    w2 = edge(p0, p1, origin) - (isTopLeft(p0, p1) ? 0 : 1);
+
+    // Per-cell increments
+    stepX0 = (p1.y - p2.y) * SUBPIXEL_ONE;
+    stepX1 = (p2.y - p0.y) * SUBPIXEL_ONE;
+    stepX2 = (p0.y - p1.y) * SUBPIXEL_ONE;
+    stepY0 = (p2.x - p1.x) * SUBPIXEL_ONE;
+    stepY1 = (p0.x - p2.x) * SUBPIXEL_ONE;
+    stepY2 = (p1.x - p0.x) * SUBPIXEL_ONE;
+
+    invArea = 1.f / static_cast<float>(area);
+
+    int columns = maxX - minX, rows = maxY - minY;
+    fitsInt32 = edgeRange(w0, stepX0, stepY0, columns, rows) <= INT32_MAX &&
+                edgeRange(w1, stepX1, stepY1, columns, rows) <= INT32_MAX &&
+                edgeRange(w2, stepX2, stepY2, columns, rows) <= INT32_MAX;
+
+    return true;
+}
+
+namespace
+{
+    template <raster::ShadingMode Mode, bool DepthTest>
+    void shadeSpanScalar(const raster::Span &span, int count, Glyph *out, float *depth, color::CellColor *colors)
+    {
+        int64_t w0 = span.w0, w1 = span.w1, w2 = span.w2;
+
+        for (int i = 0; i < count; ++i, w0 += span.stepX0, w1 += span.stepX1, w2 += span.stepX2)
+        {
+            // Check if the cell center is inside the triangle
+            if ((w0 | w1 | w2) < 0)
+                continue;
+
+            // Barycentric coordinates come straight from the edge values
+            float alpha = w0 * span.invArea;
+            float beta = w1 * span.invArea;
+            float gamma = w2 * span.invArea;
+
+            // Early depth test, before any shading work
+            if (DepthTest)
+            {
+                float z = alpha * span.z0 + beta * span.z1 + gamma * span.z2;
+                if (!(z < depth[i]))
+                    continue;
+
+                depth[i] = z;
+            }
+
+            // The mode is a template argument, so only one of these branches is compiled
+            if (Mode == raster::ShadingMode::Flat)
+            {
+                out[i] = span.glyph;
+                if (colors)
+                    colors[i] = span.color;
+                continue;
+            }
+
+            float intensity;
+            if (Mode == raster::ShadingMode::Gouraud)
+            {
+                // Interpolate the vertex intensities (affine, like classic Gouraud shading)
+                intensity = alpha * span.i0 + beta * span.i1 + gamma * span.i2;
+            }
+            else
+            {
+                // Interpolate the normal with perspective correction (its length is normalized away)
+                float k0 = alpha * span.invW0, k1 = beta * span.invW1, k2 = gamma * span.invW2;
+                fVec3 normal = span.n0 * k0 + span.n1 * k1 + span.n2 * k2;
+
+                // Normalize the interpolated normal
+                normal = normal.normalize();
+
+                // Accumulate the directional lights; the cost per light is one dot product
+                intensity = span.ambient;
+                for (int light = 0; light < span.lightCount; ++light)
+                    intensity += std::max(0.f, normal.dot(span.lights[light]));
+
+                // Point lights from the cell's world position, interpolated like the normal but
+                // with the weights normalized
+                if (span.pointCount > 0)
+                {
+                    fVec3 position = (span.p0 * k0 + span.p1 * k1 + span.p2 * k2) * (1.f / (k0 + k1 + k2));
+
+                    for (int light = 0; light < span.pointCount; ++light)
+                    {
+                        // Light::getLightVector, with the scale applied after the dot product
+                        // (a light at the position itself gives NaN, which adds 0)
+                        fVec3 toLight = span.pointPositions[light] - position;
+                        float distance = toLight.length();
+                        float scale = span.pointIntensities[light] / (distance * (1.f + span.pointAttenuations[light] * distance * distance));
+                        intensity += std::max(0.f, normal.dot(toLight) * scale);
+                    }
+                }
+            }
+
+            // Clamp the intensity to the range [0, 1]
+            intensity = std::max(0.f, std::min(intensity, 1.f));
+
+            // Quantize the intensity through the lookup tables
+            int index = raster::getShadeIndex(intensity);
+            out[i] = span.shades[index];
+            if (colors)
+                colors[i] = span.colors[index];
+        }
+    }
+}
+
+const raster::SpanKernels &raster::getScalarKernels()
+{
+    static const SpanKernels kernels = {
+        "scalar",
+        {{shadeSpanScalar<ShadingMode::Flat, false>, shadeSpanScalar<ShadingMode::Flat, true>},
+         {shadeSpanScalar<ShadingMode::Gouraud, false>, shadeSpanScalar<ShadingMode::Gouraud, true>},
+         {shadeSpanScalar<ShadingMode::PerCell, false>, shadeSpanScalar<ShadingMode::PerCell, true>}}};
+
+    return kernels;
+}
+
+const raster::SpanKernels &raster::selectSpanKernels()
+{
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return getAVX2Kernels();
+    if (__builtin_cpu_supports("sse2"))
+        return getSSE2Kernels();
+#endif
+
+    return getScalarKernels();
+}
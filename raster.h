@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "framebuffer.h"
+#include "math.h"
+
+namespace raster
+{
+    // How triangles are lit: once per triangle from the sum of the vertex normals (Flat), once
+    // per vertex with the intensity interpolated across the triangle (Gouraud), or per cell
+    // from the perspective-correct interpolated normal (PerCell)
+    enum class ShadingMode
+    {
+        Flat,
+        Gouraud,
+        PerCell
+    };
+    const int SHADING_MODES = 3;
+
+    // Lights a span can accumulate per cell
+    const int MAX_LIGHTS = 8;
+
+    // Entries of the intensity to glyph lookup table, filled from a shade ramp of any length
+    const int SHADE_LUT_SIZE = 256;
+
+    // Vertex positions are snapped to 1/16th of a cell
+    const int SUBPIXEL_BITS = 4;
+    const int SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+
+    // Triangles reaching further than this (in cells) are rejected before snapping
+    const float GUARD_BAND = 16384.f;
+
+    // Convert a screen coordinate to fixed-point
+    inline int32_t toFixed(float value)
+    {
+        return static_cast<int32_t>(std::lround(value * SUBPIXEL_ONE));
+    }
+
+    // Edge equations of a triangle, set up once and stepped per cell
+    struct Triangle
+    {
+        // Bounding box in cells, clamped to the target
+        int minX, minY, maxX, maxY;
+
+        // Edge values at the center of cell (minX, minY), with the fill rule bias applied
+        int64_t w0, w1, w2;
+
+        // Edge increments for one cell to the right and one cell down
+        int64_t stepX0, stepX1, stepX2;
+        int64_t stepY0, stepY1, stepY2;
+
+        // Reciprocal of twice the triangle area, converts edge values to barycentrics
+        float invArea;
+
+        // True if every edge value inside the bounding box fits in 32 bits (required by the SIMD kernels)
+        bool fitsInt32;
+
+        // Returns false if the triangle is backfacing, degenerate or covers no cells
+        bool setup(const fVec2 &v0, const fVec2 &v1, const fVec2 &v2, int width, int height);
+    };
+
+    // Inputs of a span kernel: one row of a triangle starting at its first cell
+    struct Span
+    {
+        int64_t w0, w1, w2;
+        int64_t stepX0, stepX1, stepX2;
+        float invArea;
+
+        // Per-vertex depth, 1 / w and normals
+        float z0, z1, z2;
+        float invW0, invW1, invW2;
+        fVec3 n0, n1, n2;
+
+        // PerCell: vectors towards the directional lights, scaled by their intensity, and the
+        // ambient intensity the light terms are added to
+        fVec3 lights[MAX_LIGHTS];
+        int lightCount;
+        float ambient;
+
+        // PerCell: point lights (position, intensity and attenuation as in Light), resolved per
+        // cell at the world position interpolated from the per-vertex ones
+        fVec3 p0, p1, p2;
+        fVec3 pointPositions[MAX_LIGHTS];
+        float pointIntensities[MAX_LIGHTS], pointAttenuations[MAX_LIGHTS];
+        int pointCount;
+
+        // Per-vertex light intensity (Gouraud) and the glyph of the whole triangle (Flat)
+        float i0, i1, i2;
+        Glyph glyph;
+
+        // SHADE_LUT_SIZE glyphs and the matching cell colors, darkest first (the colors are
+        // only read by kernels writing colors)
+        const Glyph *shades;
+        const color::CellColor *colors;
+
+        // Color of every cell of a Flat triangle (the entry of its glyph)
+        color::CellColor color;
+    };
+
+    // Entry of the shade lookup table of a light intensity in [0, 1]
+    inline int getShadeIndex(float intensity)
+    {
+        return static_cast<int>(std::min(intensity * SHADE_LUT_SIZE, SHADE_LUT_SIZE - 1.f));
+    }
+
+    // Quantize a light intensity in [0, 1] through the shade lookup table
+    inline Glyph getShade(float intensity, const Glyph *shades)
+    {
+        return shades[getShadeIndex(intensity)];
+    }
+
+    // Shades count cells of a span, writing a glyph into out[i] (and its color into colors[i],
+    // unless colors is null) for every covered cell and leaving the other cells untouched.
+    // Kernels with depth testing only shade a cell (and update depth[i]) when it is closer
+    // than depth[i]; the others ignore depth.
+    typedef void (*SpanKernel)(const Span &span, int count, Glyph *out, float *depth, color::CellColor *colors);
+
+    // Kernels of one instruction set, one instantiation per shading mode and depth test
+    struct SpanKernels
+    {
+        const char *name;
+        SpanKernel kernels[SHADING_MODES][2];
+
+        inline SpanKernel get(ShadingMode mode, bool depthTest) const
+        {
+            return kernels[static_cast<int>(mode)][depthTest];
+        }
+    };
+
+    // The SIMD kernels only handle triangles that fit in 32 bits
+    const SpanKernels &getScalarKernels();
+    const SpanKernels &getSSE2Kernels();
+    const SpanKernels &getAVX2Kernels();
+
+    // Pick the widest kernels the CPU supports
+    const SpanKernels &selectSpanKernels();
+}
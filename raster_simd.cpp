@@ -0,0 +1,389 @@
+#include "raster.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <cstring>
+#include <immintrin.h>
+
+// Both kernels evaluate the same operations in the same order as shadeSpanScalar,
+// so they produce identical glyphs; only the lane count differs.
+
+namespace
+{
+    template <raster::ShadingMode Mode, bool DepthTest>
+    __attribute__((target("sse2"))) void shadeSpanSSE2(const raster::Span &span, int count, Glyph *out, float *depth, color::CellColor *colors)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 lutSize = _mm_set1_ps(static_cast<float>(raster::SHADE_LUT_SIZE));
+        const __m128 lutLast = _mm_set1_ps(static_cast<float>(raster::SHADE_LUT_SIZE - 1));
+
+        const __m128 invArea = _mm_set1_ps(span.invArea);
+        const __m128 z0 = _mm_set1_ps(span.z0), z1 = _mm_set1_ps(span.z1), z2 = _mm_set1_ps(span.z2);
+        const __m128 invW0 = _mm_set1_ps(span.invW0), invW1 = _mm_set1_ps(span.invW1), invW2 = _mm_set1_ps(span.invW2);
+        const __m128 ambient = _mm_set1_ps(span.ambient);
+        __m128 lightX[raster::MAX_LIGHTS], lightY[raster::MAX_LIGHTS], lightZ[raster::MAX_LIGHTS];
+        for (int light = 0; light < span.lightCount; ++light)
+        {
+            lightX[light] = _mm_set1_ps(span.lights[light].x);
+            lightY[light] = _mm_set1_ps(span.lights[light].y);
+            lightZ[light] = _mm_set1_ps(span.lights[light].z);
+        }
+        const __m128 i0 = _mm_set1_ps(span.i0), i1 = _mm_set1_ps(span.i1), i2 = _mm_set1_ps(span.i2);
+        __m128 pointX[raster::MAX_LIGHTS], pointY[raster::MAX_LIGHTS], pointZ[raster::MAX_LIGHTS];
+        __m128 pointIntensity[raster::MAX_LIGHTS], pointAttenuation[raster::MAX_LIGHTS];
+        for (int light = 0; light < span.pointCount; ++light)
+        {
+            pointX[light] = _mm_set1_ps(span.pointPositions[light].x);
+            pointY[light] = _mm_set1_ps(span.pointPositions[light].y);
+            pointZ[light] = _mm_set1_ps(span.pointPositions[light].z);
+            pointIntensity[light] = _mm_set1_ps(span.pointIntensities[light]);
+            pointAttenuation[light] = _mm_set1_ps(span.pointAttenuations[light]);
+        }
+
+        // Edge values of the four lanes, and their increment per block
+        const int32_t s0 = static_cast<int32_t>(span.stepX0), s1 = static_cast<int32_t>(span.stepX1), s2 = static_cast<int32_t>(span.stepX2);
+        __m128i w0 = _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(span.w0)), _mm_setr_epi32(0, s0, 2 * s0, 3 * s0));
+        __m128i w1 = _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(span.w1)), _mm_setr_epi32(0, s1, 2 * s1, 3 * s1));
+        __m128i w2 = _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(span.w2)), _mm_setr_epi32(0, s2, 2 * s2, 3 * s2));
+        const __m128i step0 = _mm_set1_epi32(4 * s0), step1 = _mm_set1_epi32(4 * s1), step2 = _mm_set1_epi32(4 * s2);
+
+        for (int i = 0; i < count; i += 4)
+        {
+            // Inside test for the four cells
+            __m128i inside = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(w0, w1), w2), _mm_set1_epi32(-1));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+
+            if (count - i < 4)
+                mask &= (1 << (count - i)) - 1;
+
+            // Barycentric coordinates
+            __m128 alpha = _mm_mul_ps(_mm_cvtepi32_ps(w0), invArea);
+            __m128 beta = _mm_mul_ps(_mm_cvtepi32_ps(w1), invArea);
+            __m128 gamma = _mm_mul_ps(_mm_cvtepi32_ps(w2), invArea);
+
+            // Early depth test, before any shading work
+            alignas(16) float zs[4];
+            if (DepthTest && mask)
+            {
+                __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, z0), _mm_mul_ps(beta, z1)), _mm_mul_ps(gamma, z2));
+                _mm_store_ps(zs, z);
+
+                for (int lane = 0; lane < 4; ++lane)
+                    if ((mask & (1 << lane)) && !(zs[lane] < depth[i + lane]))
+                        mask &= ~(1 << lane);
+            }
+
+            if (mask)
+            {
+                // The mode is a template argument, so only one of these branches is compiled
+                alignas(16) int32_t shades[4];
+                if (Mode != raster::ShadingMode::Flat)
+                {
+                    __m128 intensity;
+                    if (Mode == raster::ShadingMode::Gouraud)
+                    {
+                        // Interpolate the vertex intensities
+                        intensity = _mm_add_ps(_mm_add_ps(_mm_mul_ps(alpha, i0), _mm_mul_ps(beta, i1)), _mm_mul_ps(gamma, i2));
+                    }
+                    else
+                    {
+                        __m128 k0 = _mm_mul_ps(alpha, invW0);
+                        __m128 k1 = _mm_mul_ps(beta, invW1);
+                        __m128 k2 = _mm_mul_ps(gamma, invW2);
+
+                        // Interpolate and normalize the normal
+                        __m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.n0.x), k0), _mm_mul_ps(_mm_set1_ps(span.n1.x), k1)), _mm_mul_ps(_mm_set1_ps(span.n2.x), k2));
+                        __m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.n0.y), k0), _mm_mul_ps(_mm_set1_ps(span.n1.y), k1)), _mm_mul_ps(_mm_set1_ps(span.n2.y), k2));
+                        __m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.n0.z), k0), _mm_mul_ps(_mm_set1_ps(span.n1.z), k1)), _mm_mul_ps(_mm_set1_ps(span.n2.z), k2));
+
+                        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+                        nx = _mm_div_ps(nx, length);
+                        ny = _mm_div_ps(ny, length);
+                        nz = _mm_div_ps(nz, length);
+
+                        // Accumulate the lights (NaN from a zero normal adds 0)
+                        intensity = ambient;
+                        for (int light = 0; light < span.lightCount; ++light)
+                        {
+                            __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, lightX[light]), _mm_mul_ps(ny, lightY[light])), _mm_mul_ps(nz, lightZ[light]));
+                            intensity = _mm_add_ps(intensity, _mm_max_ps(dot, zero));
+                        }
+
+                        // Point lights from the cell's world position (NaN from a light at the
+                        // position itself adds 0)
+                        if (span.pointCount > 0)
+                        {
+                            __m128 invK = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(k0, k1), k2));
+                            __m128 px = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.p0.x), k0), _mm_mul_ps(_mm_set1_ps(span.p1.x), k1)), _mm_mul_ps(_mm_set1_ps(span.p2.x), k2)), invK);
+                            __m128 py = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.p0.y), k0), _mm_mul_ps(_mm_set1_ps(span.p1.y), k1)), _mm_mul_ps(_mm_set1_ps(span.p2.y), k2)), invK);
+                            __m128 pz = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.p0.z), k0), _mm_mul_ps(_mm_set1_ps(span.p1.z), k1)), _mm_mul_ps(_mm_set1_ps(span.p2.z), k2)), invK);
+
+                            for (int light = 0; light < span.pointCount; ++light)
+                            {
+                                __m128 tx = _mm_sub_ps(pointX[light], px);
+                                __m128 ty = _mm_sub_ps(pointY[light], py);
+                                __m128 tz = _mm_sub_ps(pointZ[light], pz);
+
+                                __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz)));
+                                __m128 scale = _mm_div_ps(pointIntensity[light], _mm_mul_ps(distance, _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(pointAttenuation[light], distance), distance))));
+                                __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+                                intensity = _mm_add_ps(intensity, _mm_max_ps(_mm_mul_ps(dot, scale), zero));
+                            }
+                        }
+                    }
+
+                    // Clamp to [0, 1] and scale to an index of the lookup table
+                    intensity = _mm_min_ps(_mm_max_ps(intensity, zero), one);
+                    _mm_store_si128(reinterpret_cast<__m128i *>(shades), _mm_cvttps_epi32(_mm_min_ps(_mm_mul_ps(intensity, lutSize), lutLast)));
+                }
+
+                // Masked write of the covered cells
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    if (mask & (1 << lane))
+                    {
+                        out[i + lane] = Mode == raster::ShadingMode::Flat ? span.glyph : span.shades[shades[lane]];
+                        if (DepthTest)
+                            depth[i + lane] = zs[lane];
+                        if (colors)
+                            colors[i + lane] = Mode == raster::ShadingMode::Flat ? span.color : span.colors[shades[lane]];
+                    }
+                }
+            }
+
+            w0 = _mm_add_epi32(w0, step0);
+            w1 = _mm_add_epi32(w1, step1);
+            w2 = _mm_add_epi32(w2, step2);
+        }
+    }
+
+    template <raster::ShadingMode Mode, bool DepthTest>
+    __attribute__((target("avx2"))) void shadeSpanAVX2(const raster::Span &span, int count, Glyph *out, float *depth, color::CellColor *colors)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+        const __m256 lutSize = _mm256_set1_ps(static_cast<float>(raster::SHADE_LUT_SIZE));
+        const __m256 lutLast = _mm256_set1_ps(static_cast<float>(raster::SHADE_LUT_SIZE - 1));
+
+        const __m256 invArea = _mm256_set1_ps(span.invArea);
+        const __m256 z0 = _mm256_set1_ps(span.z0), z1 = _mm256_set1_ps(span.z1), z2 = _mm256_set1_ps(span.z2);
+        const __m256 invW0 = _mm256_set1_ps(span.invW0), invW1 = _mm256_set1_ps(span.invW1), invW2 = _mm256_set1_ps(span.invW2);
+        const __m256 ambient = _mm256_set1_ps(span.ambient);
+        __m256 lightX[raster::MAX_LIGHTS], lightY[raster::MAX_LIGHTS], lightZ[raster::MAX_LIGHTS];
+        for (int light = 0; light < span.lightCount; ++light)
+        {
+            lightX[light] = _mm256_set1_ps(span.lights[light].x);
+            lightY[light] = _mm256_set1_ps(span.lights[light].y);
+            lightZ[light] = _mm256_set1_ps(span.lights[light].z);
+        }
+        const __m256 i0 = _mm256_set1_ps(span.i0), i1 = _mm256_set1_ps(span.i1), i2 = _mm256_set1_ps(span.i2);
+        __m256 pointX[raster::MAX_LIGHTS], pointY[raster::MAX_LIGHTS], pointZ[raster::MAX_LIGHTS];
+        __m256 pointIntensity[raster::MAX_LIGHTS], pointAttenuation[raster::MAX_LIGHTS];
+        for (int light = 0; light < span.pointCount; ++light)
+        {
+            pointX[light] = _mm256_set1_ps(span.pointPositions[light].x);
+            pointY[light] = _mm256_set1_ps(span.pointPositions[light].y);
+            pointZ[light] = _mm256_set1_ps(span.pointPositions[light].z);
+            pointIntensity[light] = _mm256_set1_ps(span.pointIntensities[light]);
+            pointAttenuation[light] = _mm256_set1_ps(span.pointAttenuations[light]);
+        }
+
+        // Edge values of the eight lanes, and their increment per block
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const int32_t s0 = static_cast<int32_t>(span.stepX0), s1 = static_cast<int32_t>(span.stepX1), s2 = static_cast<int32_t>(span.stepX2);
+        __m256i w0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(span.w0)), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(s0)));
+        __m256i w1 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(span.w1)), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(s1)));
+        __m256i w2 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(span.w2)), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(s2)));
+        const __m256i step0 = _mm256_set1_epi32(8 * s0), step1 = _mm256_set1_epi32(8 * s1), step2 = _mm256_set1_epi32(8 * s2);
+
+        for (int i = 0; i < count; i += 8)
+        {
+            // Inside test for the eight cells, limited to the span
+            __m256i inside = _mm256_cmpgt_epi32(_mm256_or_si256(_mm256_or_si256(w0, w1), w2), _mm256_set1_epi32(-1));
+            inside = _mm256_and_si256(inside, _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lanes));
+
+            // Barycentric coordinates
+            __m256 alpha = _mm256_mul_ps(_mm256_cvtepi32_ps(w0), invArea);
+            __m256 beta = _mm256_mul_ps(_mm256_cvtepi32_ps(w1), invArea);
+            __m256 gamma = _mm256_mul_ps(_mm256_cvtepi32_ps(w2), invArea);
+
+            // Early depth test, before any shading work (masked load, lanes past the span are never touched)
+            __m256 z = _mm256_setzero_ps();
+            if (DepthTest && !_mm256_testz_si256(inside, inside))
+            {
+                z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(alpha, z0), _mm256_mul_ps(beta, z1)), _mm256_mul_ps(gamma, z2));
+                __m256 stored = _mm256_maskload_ps(depth + i, inside);
+                inside = _mm256_and_si256(inside, _mm256_castps_si256(_mm256_cmp_ps(z, stored, _CMP_LT_OQ)));
+            }
+
+            if (!_mm256_testz_si256(inside, inside))
+            {
+                // The mode is a template argument, so only one of these branches is compiled
+                __m128i glyph8;
+                __m256i index8 = _mm256_setzero_si256();
+                if (Mode == raster::ShadingMode::Flat)
+                    glyph8 = _mm_set1_epi8(static_cast<char>(span.glyph));
+                else
+                {
+                    __m256 intensity;
+                    if (Mode == raster::ShadingMode::Gouraud)
+                    {
+                        // Interpolate the vertex intensities
+                        intensity = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(alpha, i0), _mm256_mul_ps(beta, i1)), _mm256_mul_ps(gamma, i2));
+                    }
+                    else
+                    {
+                        __m256 k0 = _mm256_mul_ps(alpha, invW0);
+                        __m256 k1 = _mm256_mul_ps(beta, invW1);
+                        __m256 k2 = _mm256_mul_ps(gamma, invW2);
+
+                        // Interpolate and normalize the normal
+                        __m256 nx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.n0.x), k0), _mm256_mul_ps(_mm256_set1_ps(span.n1.x), k1)), _mm256_mul_ps(_mm256_set1_ps(span.n2.x), k2));
+                        __m256 ny = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.n0.y), k0), _mm256_mul_ps(_mm256_set1_ps(span.n1.y), k1)), _mm256_mul_ps(_mm256_set1_ps(span.n2.y), k2));
+                        __m256 nz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.n0.z), k0), _mm256_mul_ps(_mm256_set1_ps(span.n1.z), k1)), _mm256_mul_ps(_mm256_set1_ps(span.n2.z), k2));
+
+                        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz)));
+                        nx = _mm256_div_ps(nx, length);
+                        ny = _mm256_div_ps(ny, length);
+                        nz = _mm256_div_ps(nz, length);
+
+                        // Accumulate the lights (NaN from a zero normal adds 0)
+                        intensity = ambient;
+                        for (int light = 0; light < span.lightCount; ++light)
+                        {
+                            __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, lightX[light]), _mm256_mul_ps(ny, lightY[light])), _mm256_mul_ps(nz, lightZ[light]));
+                            intensity = _mm256_add_ps(intensity, _mm256_max_ps(dot, zero));
+                        }
+
+                        // Point lights from the cell's world position (NaN from a light at the
+                        // position itself adds 0)
+                        if (span.pointCount > 0)
+                        {
+                            __m256 invK = _mm256_div_ps(one, _mm256_add_ps(_mm256_add_ps(k0, k1), k2));
+                            __m256 px = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.p0.x), k0), _mm256_mul_ps(_mm256_set1_ps(span.p1.x), k1)), _mm256_mul_ps(_mm256_set1_ps(span.p2.x), k2)), invK);
+                            __m256 py = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.p0.y), k0), _mm256_mul_ps(_mm256_set1_ps(span.p1.y), k1)), _mm256_mul_ps(_mm256_set1_ps(span.p2.y), k2)), invK);
+                            __m256 pz = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.p0.z), k0), _mm256_mul_ps(_mm256_set1_ps(span.p1.z), k1)), _mm256_mul_ps(_mm256_set1_ps(span.p2.z), k2)), invK);
+
+                            for (int light = 0; light < span.pointCount; ++light)
+                            {
+                                __m256 tx = _mm256_sub_ps(pointX[light], px);
+                                __m256 ty = _mm256_sub_ps(pointY[light], py);
+                                __m256 tz = _mm256_sub_ps(pointZ[light], pz);
+
+                                __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty)), _mm256_mul_ps(tz, tz)));
+                                __m256 scale = _mm256_div_ps(pointIntensity[light], _mm256_mul_ps(distance, _mm256_add_ps(one, _mm256_mul_ps(_mm256_mul_ps(pointAttenuation[light], distance), distance))));
+                                __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, tx), _mm256_mul_ps(ny, ty)), _mm256_mul_ps(nz, tz));
+                                intensity = _mm256_add_ps(intensity, _mm256_max_ps(_mm256_mul_ps(dot, scale), zero));
+                            }
+                        }
+                    }
+
+                    // Clamp to [0, 1], scale to an index of the lookup table and look the glyphs up
+                    intensity = _mm256_min_ps(_mm256_max_ps(intensity, zero), one);
+
+                    index8 = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_mul_ps(intensity, lutSize), lutLast));
+
+                    alignas(32) int32_t index[8];
+                    _mm256_store_si256(reinterpret_cast<__m256i *>(index), index8);
+
+                    alignas(16) Glyph shaded[16];
+                    for (int lane = 0; lane < 8; ++lane)
+                        shaded[lane] = span.shades[index[lane]];
+
+                    glyph8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(shaded));
+                }
+
+                // Narrow the mask to bytes
+                __m128i mask16 = _mm_packs_epi32(_mm256_castsi256_si128(inside), _mm256_extracti128_si256(inside, 1));
+                __m128i mask8 = _mm_packs_epi16(mask16, mask16);
+
+                // Masked write of the covered cells. Whole blocks blend in place; the last partial
+                // block writes lane by lane so it never touches cells past the span (another tile's)
+                if (count - i >= 8)
+                {
+                    __m128i stored = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(out + i));
+                    stored = _mm_or_si128(_mm_and_si128(mask8, glyph8), _mm_andnot_si128(mask8, stored));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), stored);
+                }
+                else
+                {
+                    alignas(16) Glyph glyphs[16], mask[16];
+                    _mm_store_si128(reinterpret_cast<__m128i *>(glyphs), glyph8);
+                    _mm_store_si128(reinterpret_cast<__m128i *>(mask), mask8);
+
+                    for (int lane = 0; lane < count - i; ++lane)
+                        if (mask[lane])
+                            out[i + lane] = glyphs[lane];
+                }
+
+                if (DepthTest)
+                    _mm256_maskstore_ps(depth + i, inside, z);
+
+                // Masked write of the colors, four 64-bit cells at a time (lanes past the span are
+                // never touched), gathered from the color table by the glyph indices
+                if (colors)
+                {
+                    __m256i lowColors, highColors;
+                    if (Mode == raster::ShadingMode::Flat)
+                    {
+                        long long packed;
+                        std::memcpy(&packed, &span.color, sizeof(packed));
+                        lowColors = highColors = _mm256_set1_epi64x(packed);
+                    }
+                    else
+                    {
+                        const long long *table = reinterpret_cast<const long long *>(span.colors);
+                        lowColors = _mm256_i32gather_epi64(table, _mm256_castsi256_si128(index8), 8);
+                        highColors = _mm256_i32gather_epi64(table, _mm256_extracti128_si256(index8, 1), 8);
+                    }
+
+                    long long *target = reinterpret_cast<long long *>(colors + i);
+                    _mm256_maskstore_epi64(target, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(inside)), lowColors);
+                    _mm256_maskstore_epi64(target + 4, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(inside, 1)), highColors);
+                }
+            }
+
+            w0 = _mm256_add_epi32(w0, step0);
+            w1 = _mm256_add_epi32(w1, step1);
+            w2 = _mm256_add_epi32(w2, step2);
+        }
+    }
+}
+
+const raster::SpanKernels &raster::getSSE2Kernels()
+{
+    static const SpanKernels kernels = {
+        "sse2",
+        {{shadeSpanSSE2<ShadingMode::Flat, false>, shadeSpanSSE2<ShadingMode::Flat, true>},
+         {shadeSpanSSE2<ShadingMode::Gouraud, false>, shadeSpanSSE2<ShadingMode::Gouraud, true>},
+         {shadeSpanSSE2<ShadingMode::PerCell, false>, shadeSpanSSE2<ShadingMode::PerCell, true>}}};
+
+    return kernels;
+}
+
+const raster::SpanKernels &raster::getAVX2Kernels()
+{
+    static const SpanKernels kernels = {
+        "avx2",
+        {{shadeSpanAVX2<ShadingMode::Flat, false>, shadeSpanAVX2<ShadingMode::Flat, true>},
+         {shadeSpanAVX2<ShadingMode::Gouraud, false>, shadeSpanAVX2<ShadingMode::Gouraud, true>},
+         {shadeSpanAVX2<ShadingMode::PerCell, false>, shadeSpanAVX2<ShadingMode::PerCell, true>}}};
+
+    return kernels;
+}
+
+#else
+
+// No SIMD kernels on this architecture, selectSpanKernels never returns these
+const raster::SpanKernels &raster::getSSE2Kernels()
+{
+    return getScalarKernels();
+}
+
+const raster::SpanKernels &raster::getAVX2Kernels()
+{
+    return getScalarKernels();
+}
+
+#endif
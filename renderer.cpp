@@ -1,285 +1,910 @@
-#include "renderer.h"
-
-Renderer::Renderer(int width, int height)
-    : width(width), height(height)
-{
-    // Allocate rows
-    backBuffer = new wchar_t *[width];
-
-    // Allocate columns
-    for (int x = 0; x < width; ++x)
-        backBuffer[x] = new wchar_t[height];
-
-    // Fill with background char
-    for (int x = 0; x < width; ++x)
-        for (int y = 0; y < height; ++y)
-            backBuffer[x][y] = background;
-
-    // Allocate screen buffer
-    screen = new wchar_t[width * 2 * height + height + 1]();
-
-    // Disable buffering, hide cursor and clear the console
-    Console::disableBuffering();
-    Console::hideCursor();
-    Console::clear();
-}
-
-Renderer::~Renderer()
-{
-    // Free memory
-    for (int i = 0; i < width; ++i)
-        delete[] backBuffer[i];
-
-    delete[] backBuffer;
-    delete[] screen;
-}
-
-void Renderer::begin()
-{
-    // Clear the back buffer
-    for (int x = 0; x < width; ++x)
-        for (int y = 0; y < height; ++y)
-            if (backBuffer[x][y] != background)
-                backBuffer[x][y] = background;
-
-    // Clear the screen
-    Console::clear();
-}
-void Renderer::draw(Vertex *vertices, int *indices, int indiciesCount)
-{
-    // Iterate over all triangles (each triangle has 3 indices)
-    for (int i = 0; i < indiciesCount / 3; ++i)
-    {
-        // Indices of the current triangle
-        int triIndices[3] = {
-            indices[i * 3],
-            indices[i * 3 + 1],
-            indices[i * 3 + 2]};
-
-        // Draw the triangle
-        tri(vertices, triIndices);
-    }
-}
-void Renderer::draw(Mesh &mesh)
-{
-    draw(mesh.getVertices(), mesh.getIndices(), mesh.getIndicesCount());
-}
-void Renderer::render()
-{
-    // Calculate the frames per second
-    static auto lastTime = std::chrono::high_resolution_clock::now();
-    static int frameCount = 0;
-    static float fps = 0.0f;
-
-    frameCount++;
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<float> elapsedTime = currentTime - lastTime;
-
-    if (elapsedTime.count() >= 1.0f)
-    {
-        fps = frameCount;
-        frameCount = 0;
-        lastTime = currentTime;
-    }
-
-    // Display the frames per second
-    displayFPS(fps);
-
-    // Draw the back buffer to the screen buffer
-    int screenIndex = 0;
-    for (int y = 0; y < height; ++y)
-    {
-        for (int x = 0; x < width; ++x)
-        {
-            // Draw the character twice for more accurate aspect ratio
-            screen[screenIndex++] = backBuffer[x][y];
-            screen[screenIndex++] = backBuffer[x][y];
-        }
-        screen[screenIndex++] = L'\n';
-    }
-    screen[screenIndex] = L'\0';
-
-    Console::fastwrite(screen);
-}
-
-void Renderer::set(iVec2 pos)
-{
-    // Check if the position is out of bounds
-    if (pos.x < 0 || pos.x >= width || pos.y < 0 || pos.y >= height)
-        return;
-
-    // Check if the character is different
-    if (backBuffer[pos.x][pos.y] == fill)
-        return;
-
-    // Set the character
-    backBuffer[pos.x][pos.y] = fill;
-}
-void Renderer::line(iVec2 start, iVec2 end)
-{
-    // Bresenham's line algorithm
-    int dx = abs(end.x - start.x);
-    int dy = abs(end.y - start.y);
-
-    int sx = start.x < end.x ? 1 : -1;
-    int sy = start.y < end.y ? 1 : -1;
-
-    int err = dx - dy;
-
-    iVec2 current = start;
-    while (current != end)
-    {
-        set(current);
-
-        int e2 = 2 * err;
-        if (e2 > -dy)
-        {
-            err -= dy;
-            current.x += sx;
-        }
-        if (e2 < dx)
-        {
-            err += dx;
-            current.y += sy;
-        }
-    }
-}
-void Renderer::line(fVec3 start, fVec3 end)
-{
-    // Line in world space
-    iVec2 screenStart = worldToScreen(start);
-    iVec2 screenEnd = worldToScreen(end);
-
-    line(screenStart, screenEnd);
-}
-void Renderer::tri(Vertex *vertices, int *indices)
-{
-    // Convert the vertices to screen space
-    iVec2 v0 = worldToScreen(vertices[indices[0]].position);
-    iVec2 v1 = worldToScreen(vertices[indices[1]].position);
-    iVec2 v2 = worldToScreen(vertices[indices[2]].position);
-
-    // Check if the triangle is backfacing
-    float area = math::triArea(v0, v1, v2);
-    if (area <= 0)
-        return; // Early exit if the triangle is backfacing
-
-    // Fill the triangle
-    int minX = std::min({v0.x, v1.x, v2.x});
-    int maxX = std::max({v0.x, v1.x, v2.x});
-    int minY = std::min({v0.y, v1.y, v2.y});
-    int maxY = std::max({v0.y, v1.y, v2.y});
-
-    // Iterate over all pixels inside the bounding box
-    for (int y = minY; y <= maxY; ++y)
-    {
-        for (int x = minX; x <= maxX; ++x)
-        {
-            iVec2 p = {x, y};
-
-            // Check if the point (x, y) is inside the triangle
-            if (math::edgeFunction(v0, v1, p) &&
-                math::edgeFunction(v1, v2, p) &&
-                math::edgeFunction(v2, v0, p))
-            {
-                // Calculate the barycentric coordinates
-                float A0 = math::triArea(p, v1, v2);
-                float A1 = math::triArea(v0, p, v2);
-                float A2 = math::triArea(v0, v1, p);
-
-                float alpha = A0 / area;
-                float beta = A1 / area;
-                float gamma = A2 / area;
-
-                // Interpolate the vertex attributes
-                float z = 1.f / (alpha / vertices[indices[0]].position.z + beta / vertices[indices[1]].position.z + gamma / vertices[indices[2]].position.z);
-                fVec3 normal = (vertices[indices[0]].normals * alpha + vertices[indices[1]].normals * beta + vertices[indices[2]].normals * gamma) * z;
-
-                // Calculate the light direction
-                fVec3 lightDir = fVec3(0, 0, 1);
-
-                // Normalize the interpolated normal
-                normal = normal.normalize();
-
-                // Calculate the light intensity based on the interpolated normal
-                float intensity = std::max(0.f, normal.dot(lightDir));
-
-                // Clamp the intensity to the range [0, 1]
-                intensity = std::max(0.f, std::min(intensity, 1.f));
-
-                // Set the pixel color based on the intensity
-                fill = Light::getShade(intensity);
-                set({x, y});
-            }
-        }
-    }
-}
-void Renderer::createProjectionMatrix(float fov, float near, float far)
-{
-    // Create a perspective projection matrix
-    float scale = 1.f / tan(fov * .5f);
-
-    projectionMatrix[0][0] = scale / (width / height);
-    projectionMatrix[1][1] = scale;
-    projectionMatrix[2][2] = (far + near) / (near - far);
-    projectionMatrix[2][3] = (2 * far * near) / (near - far);
-    projectionMatrix[3][2] = -1;
-    projectionMatrix[3][3] = 0;
-}
-void Renderer::createViewMatrix(float camX, float camY, float camZ)
-{
-    // Create a view matrix
-    viewMatrix[0][0] = 1;
-    viewMatrix[0][1] = 0;
-    viewMatrix[0][2] = 0;
-    viewMatrix[0][3] = -camX;
-    viewMatrix[1][0] = 0;
-    viewMatrix[1][1] = 1;
-    viewMatrix[1][2] = 0;
-    viewMatrix[1][3] = -camY;
-    viewMatrix[2][0] = 0;
-    viewMatrix[2][1] = 0;
-    viewMatrix[2][2] = 1;
-    viewMatrix[2][3] = -camZ;
-    viewMatrix[3][0] = 0;
-    viewMatrix[3][1] = 0;
-    viewMatrix[3][2] = 0;
-    viewMatrix[3][3] = 1;
-}
-
-iVec2 Renderer::worldToScreen(const fVec3 &worldPos)
-{
-    // Convert world space to screen space
-    fMat worldPosMat(4, 1);
-
-    worldPosMat[0][0] = worldPos.x;
-    worldPosMat[1][0] = worldPos.y;
-    worldPosMat[2][0] = worldPos.z;
-    worldPosMat[3][0] = 1.f;
-
-    fMat clipPosMat = projectionMatrix * viewMatrix * worldPosMat;
-
-    if (clipPosMat[3][0] == 0)
-        return iVec2();
-
-    clipPosMat[0][0] /= clipPosMat[3][0];
-    clipPosMat[1][0] /= clipPosMat[3][0];
-    clipPosMat[2][0] /= clipPosMat[3][0];
-
-    if (clipPosMat[2][0] < 0.f || clipPosMat[2][0] > 1.f)
-        return iVec2();
-
-    iVec2 screenPos;
-
-    screenPos.x = (clipPosMat[0][0] + 1.f) * .5f * width;
-    screenPos.y = (1.f - clipPosMat[1][0]) * .5f * height;
-
-    return screenPos;
-}
-
-void Renderer::displayFPS(float fps)
-{
-    wchar_t buffer[50]; // Buffer to hold the output
-    swprintf(buffer, sizeof(buffer) / sizeof(wchar_t), L"FPS: %d\n", static_cast<int>(fps));
-    Console::fastwrite(buffer); // Write directly to the console
-}
\ No newline at end of file
+#include "renderer.h"
+
+Renderer::Renderer(int width, int height, RenderTarget target, CellMode cellMode)
+    : width(width * 2 / subcell::getCellWidth(cellMode) * subcell::getPixelsX(cellMode)),
+      height(height * subcell::getPixelsY(cellMode)),
+      cellMode(cellMode), columns(width * 2 / subcell::getCellWidth(cellMode)), rows(height),
+      presenter(columns, rows, cellMode == CellMode::Shaded ? palette : cellPalette, subcell::getCellWidth(cellMode)),
+      presenting(target == RenderTarget::Console), guardBand(clip::getGuardBand(this->width, this->height))
+{
+    // Register the glyphs (the background is index 0, so fresh framebuffers are blank)
+    background = palette.add(' ');
+    fill = palette.add(0x2588);
+
+    // Block shades and the default light
+    wchar_t ramp[Light::SHADE_LEVELS + 1] = {};
+    for (int i = 0; i < Light::SHADE_LEVELS; ++i)
+        ramp[i] = Light::getShadeLevel(i);
+
+    setShadeRamp(ramp);
+    addLight(Light::directional(fVec3(0, 0, 1)));
+
+    // Pixels are drawn as light levels and packed into cells of their own palette. Covered
+    // pixels start above the lowest dither threshold (8), so even unlit ones keep some dots;
+    // level 0 is left to the background.
+    for (int i = 0; i < raster::SHADE_LUT_SIZE; ++i)
+        levels[i] = static_cast<Glyph>(9 + i * (subcell::FULL_LEVEL - 9) / (raster::SHADE_LUT_SIZE - 1));
+
+    if (cellMode != CellMode::Shaded)
+    {
+        subcell::fillPalette(cellMode, cellPalette);
+        pixels = new Framebuffer(this->width, this->height, framePlanes);
+    }
+
+    // Allocate the framebuffer and fill it with the background char
+    frames[0] = framebuffer = new Framebuffer(columns, rows, framePlanes);
+    framebuffer->clear(background);
+
+    // Pick the raster and vertex kernels for this CPU
+    spanKernels = &raster::selectSpanKernels();
+    transformKernel = transform::selectTransformKernel();
+
+    // Disable buffering, hide cursor and clear the console
+    if (target == RenderTarget::Console)
+    {
+        Console::disableBuffering();
+        Console::hideCursor();
+        Console::clear();
+    }
+}
+
+Renderer::~Renderer()
+{
+    // Stop the present thread before freeing the frames it reads
+    delete asyncPresenter;
+
+    // Free memory
+    for (Framebuffer *frame : frames)
+        delete frame;
+    delete pixels;
+    delete scheduler;
+}
+
+void Renderer::begin()
+{
+    Profiler::Scope scope(&profiler, Stage::Clear);
+
+    // Clear the glyph and depth planes (packing overwrites every cell in the sub-cell modes)
+    if (pixels)
+        pixels->clear(0);
+    else
+        framebuffer->clear(background);
+
+    culledMeshes = 0;
+
+    // Empty the tile bins
+    binnedTriangles.clear();
+    for (std::vector<int> &bin : tileBins)
+        bin.clear();
+    shadeColors.clear();
+}
+void Renderer::draw(const Vertex *vertices, const int *indices, int indiciesCount)
+{
+    // The vertex count is not known, so size the vertex stage by the highest index
+    int verticesCount = 0;
+    for (int i = 0; i < indiciesCount; ++i)
+        verticesCount = std::max(verticesCount, indices[i] + 1);
+
+    draw(vertices, verticesCount, indices, indiciesCount);
+}
+void Renderer::draw(const Vertex *vertices, int verticesCount, const int *indices, int indiciesCount)
+{
+    drawTransformed(vertices, nullptr, verticesCount, indices, indiciesCount,
+                    getModelViewProjectionMatrix(), hasModelMatrix ? &normalMatrix : nullptr);
+}
+void Renderer::draw(const VertexBuffer &vertices, const int *indices, int indiciesCount)
+{
+    drawTransformed(nullptr, &vertices, vertices.getCount(), indices, indiciesCount,
+                    getModelViewProjectionMatrix(), hasModelMatrix ? &normalMatrix : nullptr);
+}
+void Renderer::draw(const Mesh &mesh)
+{
+    // Reject meshes outside the view frustum: the sphere test is cheaper, the box test
+    // catches long thin meshes the sphere overestimates
+    if (frustumCulling)
+    {
+        BoundingSphere sphere = mesh.getBoundingSphere();
+        BoundingBox box = mesh.getBoundingBox();
+
+        if (hasModelMatrix)
+        {
+            sphere = sphere.transformed(modelMatrix);
+            box = box.transformed(modelMatrix);
+        }
+
+        const Frustum &frustum = getFrustum();
+        if (!frustum.intersects(sphere) || !frustum.intersects(box))
+        {
+            culledMeshes++;
+            return;
+        }
+    }
+
+    // The mesh transform is applied after the current model matrix
+    fMat4 model = mesh.getModelMatrix();
+    fMat4 normal = mesh.getNormalMatrix();
+
+    if (hasModelMatrix)
+    {
+        model = modelMatrix * model;
+        normal = normalMatrix * normal;
+    }
+
+    drawTransformed(mesh.getVertices(), mesh.getVertexBuffer(), mesh.getVerticesCount(),
+                    mesh.getIndices(), mesh.getIndicesCount(),
+                    getViewProjectionMatrix() * model, &normal);
+}
+void Renderer::drawInstanced(const Mesh &mesh, const fMat4 *transforms, int count)
+{
+    const int verticesCount = mesh.getVerticesCount();
+
+    // Instance transforms, applied after the mesh transform and before the current model matrix;
+    // instances outside the view frustum are dropped here
+    instances.clear();
+
+    for (int i = 0; i < count; ++i)
+    {
+        fMat4 model = transforms[i] * mesh.getModelMatrix();
+        if (hasModelMatrix)
+            model = modelMatrix * model;
+
+        if (frustumCulling)
+        {
+            const Frustum &frustum = getFrustum();
+            if (!frustum.intersects(mesh.getLocalBoundingSphere().transformed(model)) ||
+                !frustum.intersects(mesh.getLocalBoundingBox().transformed(model)))
+            {
+                culledMeshes++;
+                continue;
+            }
+        }
+
+        instances.push_back({getViewProjectionMatrix() * model, model.inverse().transpose()});
+    }
+
+    const int instancesCount = static_cast<int>(instances.size());
+    if (instancesCount == 0)
+        return;
+
+    // Every instance gets its own range of screen vertices, so instances are transformed in parallel
+    if (static_cast<int>(screenVertices.size()) < instancesCount * verticesCount)
+        screenVertices.resize(instancesCount * verticesCount);
+
+    {
+        Profiler::Scope scope(&profiler, Stage::Vertex);
+
+        auto transformInstance = [&](int i)
+        {
+            const Instance &instance = instances[i];
+            ScreenVertex *out = &screenVertices[i * verticesCount];
+
+            if (mesh.getVertexBuffer())
+                transformVertices(*mesh.getVertexBuffer(), instance.transform, &instance.normalTransform, out);
+            else
+                transformVertices(mesh.getVertices(), verticesCount, instance.transform, &instance.normalTransform, out);
+        };
+
+        if (scheduler && instancesCount > 1)
+            scheduler->run(instancesCount, transformInstance);
+        else
+            for (int i = 0; i < instancesCount; ++i)
+                transformInstance(i);
+    }
+
+    // Triangles are set up in instance order, the tiles then rasterize them in parallel
+    {
+        Profiler::Scope scope(&profiler, Stage::Raster);
+
+        for (int i = 0; i < instancesCount; ++i)
+        {
+            VertexSource source = {mesh.getVertices(), mesh.getVertexBuffer(), &instances[i].transform};
+            assembleTriangles(mesh.getIndices(), mesh.getIndicesCount(), &screenVertices[i * verticesCount], source);
+        }
+    }
+}
+void Renderer::drawTransformed(const Vertex *vertices, const VertexBuffer *vertexBuffer, int verticesCount,
+                               const int *indices, int indiciesCount,
+                               const fMat4 &transform, const fMat4 *normalTransform)
+{
+    if (vertexBuffer)
+        verticesCount = vertexBuffer->getCount();
+
+    if (static_cast<int>(screenVertices.size()) < verticesCount)
+        screenVertices.resize(verticesCount);
+
+    // Project every vertex once, then build triangles from the projected vertices
+    {
+        Profiler::Scope scope(&profiler, Stage::Vertex);
+
+        if (vertexBuffer)
+            transformVertices(*vertexBuffer, transform, normalTransform, screenVertices.data());
+        else
+            transformVertices(vertices, verticesCount, transform, normalTransform, screenVertices.data());
+    }
+    {
+        Profiler::Scope scope(&profiler, Stage::Raster);
+        VertexSource source = {vertices, vertexBuffer, &transform};
+        assembleTriangles(indices, indiciesCount, screenVertices.data(), source);
+    }
+}
+void Renderer::render()
+{
+    // Calculate the frames per second
+    fpsFrames++;
+    auto currentTime = std::chrono::steady_clock::now();
+    std::chrono::duration<float> elapsedTime = currentTime - fpsTime;
+
+    if (elapsedTime.count() >= 1.0f)
+    {
+        fps = fpsFrames;
+        fpsFrames = 0;
+        fpsTime = currentTime;
+    }
+
+    // Rasterize the binned triangles
+    if (scheduler)
+    {
+        Profiler::Scope scope(&profiler, Stage::Raster);
+        flushTiles();
+    }
+
+    // Pack the pixels into cells
+    if (pixels)
+    {
+        Profiler::Scope scope(&profiler, Stage::Raster);
+        subcell::pack(cellMode, *pixels, *framebuffer);
+    }
+
+    // The drawing stages of this frame are done (the presenter closes its own)
+    profiler.commit(Stage::Clear);
+    profiler.commit(Stage::Vertex);
+    profiler.commit(Stage::Raster);
+
+    // Offscreen without an output, the frame stays in the framebuffer for the caller
+    if (!presenting)
+        return;
+
+    // Present the frame now, or hand it to the present thread and continue with another one
+    if (asyncPresenter)
+        framebuffer = asyncPresenter->publish(fps);
+    else
+        presenter.present(*framebuffer, fps);
+}
+template <typename Update>
+void Renderer::updatePresenter(Update update)
+{
+    bool async = asyncPresenter != nullptr;
+
+    setAsyncPresent(false);
+    update();
+    setAsyncPresent(async);
+}
+void Renderer::setPresentMode(PresentMode mode)
+{
+    updatePresenter([&]
+                    { presenter.setMode(mode); });
+}
+void Renderer::setOutput(int fd)
+{
+    updatePresenter([&]
+                    { presenter.setOutput(fd); });
+    presenting = true;
+}
+void Renderer::setOutput(FrameSink sink)
+{
+    updatePresenter([&]
+                    { presenter.setOutput(std::move(sink)); });
+    presenting = true;
+}
+void Renderer::setProfiling(bool enabled, bool overlay)
+{
+    profiler.setEnabled(enabled);
+    updatePresenter([&]
+                    { presenter.setProfiler(&profiler, enabled && overlay); });
+}
+void Renderer::setColorDepth(color::Depth depth)
+{
+    int planes = Framebuffer::GLYPH | Framebuffer::DEPTH;
+    if (depth != color::Depth::None)
+        planes |= Framebuffer::COLOR;
+
+    updatePresenter([&]
+                    {
+        presenter.setColorDepth(depth);
+        if (planes == framePlanes)
+            return;
+
+        // Reallocate the frames with or without a color plane (the present thread is stopped,
+        // and recreates the frames it needs when it restarts)
+        for (Framebuffer *&frame : frames)
+        {
+            delete frame;
+            frame = nullptr;
+        }
+
+        framePlanes = planes;
+        frames[0] = framebuffer = new Framebuffer(columns, rows, framePlanes);
+        framebuffer->clear(background);
+
+        if (pixels)
+        {
+            delete pixels;
+            pixels = new Framebuffer(width, height, framePlanes);
+        } });
+}
+void Renderer::setAsyncPresent(bool enabled)
+{
+    if (!enabled)
+    {
+        delete asyncPresenter;
+        asyncPresenter = nullptr;
+        return;
+    }
+
+    if (asyncPresenter)
+        return;
+
+    // The frame being drawn becomes the back slot of the triple buffer
+    Framebuffer *order[3] = {framebuffer, nullptr, nullptr};
+    int next = 1;
+
+    for (Framebuffer *&frame : frames)
+    {
+        if (!frame)
+        {
+            frame = new Framebuffer(columns, rows, framePlanes);
+            frame->clear(background);
+        }
+        if (frame != framebuffer)
+            order[next++] = frame;
+    }
+
+    asyncPresenter = new AsyncPresenter(presenter, order);
+}
+void Renderer::set(iVec2 pos)
+{
+    // Check if the position is out of bounds
+    if (pos.x < 0 || pos.x >= width || pos.y < 0 || pos.y >= height)
+        return;
+
+    // Set the character (or light the pixel)
+    Framebuffer *target = getTarget();
+    target->glyphRow(pos.y)[pos.x] = pixels ? subcell::FULL_LEVEL : fill;
+    if (target->hasPlane(Framebuffer::COLOR))
+        target->colorRow(pos.y)[pos.x] = drawColor;
+}
+void Renderer::line(iVec2 start, iVec2 end)
+{
+    // Bresenham's line algorithm
+    int dx = abs(end.x - start.x);
+    int dy = abs(end.y - start.y);
+
+    int sx = start.x < end.x ? 1 : -1;
+    int sy = start.y < end.y ? 1 : -1;
+
+    int err = dx - dy;
+
+    iVec2 current = start;
+    while (current != end)
+    {
+        set(current);
+
+        int e2 = 2 * err;
+        if (e2 > -dy)
+        {
+            err -= dy;
+            current.x += sx;
+        }
+        if (e2 < dx)
+        {
+            err += dx;
+            current.y += sy;
+        }
+    }
+}
+void Renderer::line(fVec3 start, fVec3 end)
+{
+    // Line in world space, clipped like triangles
+    const fMat4 &transform = getViewProjectionMatrix();
+    fVec4 clipStart = transform * fVec4(start, 1.f);
+    fVec4 clipEnd = transform * fVec4(end, 1.f);
+
+    unsigned crossed = clip::getOutcode(clipStart, guardBand) | clip::getOutcode(clipEnd, guardBand);
+    if (crossed && !clip::clipLine(clipStart, clipEnd, crossed, guardBand))
+        return;
+
+    ScreenVertex screenStart, screenEnd;
+    projectToScreen(clipStart, screenStart);
+    projectToScreen(clipEnd, screenEnd);
+
+    line(iVec2(screenStart.position.x, screenStart.position.y), iVec2(screenEnd.position.x, screenEnd.position.y));
+}
+void Renderer::tri(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2)
+{
+    // Without backface culling, backfacing triangles (negative area in screen space, y down)
+    // are turned around, their normals too so that they are lit from the visible side
+    if (!backfaceCulling && math::cross(v1.position - v0.position, v2.position - v0.position) < 0.f)
+    {
+        ScreenVertex f0 = v0, f1 = v2, f2 = v1;
+        f0.normals = f0.normals * -1.f;
+        f1.normals = f1.normals * -1.f;
+        f2.normals = f2.normals * -1.f;
+
+        setupTriangle(f0, f1, f2);
+        return;
+    }
+
+    setupTriangle(v0, v1, v2);
+}
+void Renderer::setupTriangle(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2)
+{
+    // Set up the edge equations, rejecting backfacing and off-screen triangles
+    raster::Triangle t;
+    if (!t.setup(v0.position, v1.position, v2.position, width, height))
+        return;
+
+    raster::Span span;
+    span.stepX0 = t.stepX0;
+    span.stepX1 = t.stepX1;
+    span.stepX2 = t.stepX2;
+    span.invArea = t.invArea;
+    span.z0 = v0.depth;
+    span.z1 = v1.depth;
+    span.z2 = v2.depth;
+    span.invW0 = v0.invW;
+    span.invW1 = v1.invW;
+    span.invW2 = v2.invW;
+    span.n0 = v0.normals;
+    span.n1 = v1.normals;
+    span.n2 = v2.normals;
+    span.shades = pixels ? levels : shades;
+    span.colors = (framePlanes & Framebuffer::COLOR) ? getShadeColors() : nullptr;
+
+    // Point lights depend on where the triangle is, directional lights do not
+    fVec3 p0, p1, p2, center;
+    if (hasPointLights)
+    {
+        p0 = screenToWorld(v0);
+        p1 = screenToWorld(v1);
+        p2 = screenToWorld(v2);
+        center = (p0 + p1 + p2) * (1.f / 3.f);
+    }
+
+    // Light the vertices or the whole triangle once, or hand the lights to the per-cell kernels
+    // (directional lights as vectors, point lights with the vertex positions)
+    if (shadingMode == raster::ShadingMode::Gouraud)
+    {
+        span.i0 = lightIntensity(v0.normals, p0);
+        span.i1 = lightIntensity(v1.normals, p1);
+        span.i2 = lightIntensity(v2.normals, p2);
+    }
+    else if (shadingMode == raster::ShadingMode::Flat)
+    {
+        int index = raster::getShadeIndex(lightIntensity(v0.normals + v1.normals + v2.normals, center));
+        span.glyph = span.shades[index];
+        if (span.colors)
+            span.color = span.colors[index];
+    }
+    else
+    {
+        span.lightCount = span.pointCount = 0;
+        span.ambient = ambientLight;
+
+        for (int i = 0; i < lightCount; ++i)
+        {
+            if (lights[i].type == LightType::Directional)
+            {
+                span.lights[span.lightCount++] = lights[i].getLightVector(center);
+                continue;
+            }
+
+            span.pointPositions[span.pointCount] = lights[i].position;
+            span.pointIntensities[span.pointCount] = lights[i].intensity;
+            span.pointAttenuations[span.pointCount++] = lights[i].attenuation;
+        }
+
+        span.p0 = p0;
+        span.p1 = p1;
+        span.p2 = p2;
+    }
+
+    // The SIMD kernels work on 32-bit edge values, huge triangles take the scalar path
+    raster::SpanKernel kernel = (t.fitsInt32 ? *spanKernels : raster::getScalarKernels()).get(shadingMode, depthTest);
+
+    if (!scheduler)
+    {
+        rasterize(t, span, kernel, t.minX, t.minY, t.maxX, t.maxY);
+        return;
+    }
+
+    // Bin the triangle into every tile its bounding box touches
+    int index = static_cast<int>(binnedTriangles.size());
+    binnedTriangles.push_back({t, span, kernel});
+
+    for (int ty = t.minY / TILE_HEIGHT; ty <= t.maxY / TILE_HEIGHT; ++ty)
+        for (int tx = t.minX / TILE_WIDTH; tx <= t.maxX / TILE_WIDTH; ++tx)
+            tileBins[ty * tilesX + tx].push_back(index);
+}
+float Renderer::lightIntensity(const fVec3 &normal, const fVec3 &position) const
+{
+    float intensity = ambientLight;
+
+    // Same accumulation as the per-cell kernels
+    float length = normal.length();
+    if (length > 0.f)
+    {
+        fVec3 direction = normal * (1.f / length);
+        for (int i = 0; i < lightCount; ++i)
+            intensity += Light::calculateLightIntensity(direction, lights[i].getLightVector(position));
+    }
+
+    return std::max(0.f, std::min(intensity, 1.f));
+}
+const color::CellColor *Renderer::getShadeColors()
+{
+    if (!shadeColors.empty() && shadeColors.back().color == drawColor)
+        return shadeColors.back().entries;
+
+    // Entry i is lit by i / (SHADE_LUT_SIZE - 1), from black to the full draw color
+    shadeColors.emplace_back();
+    ShadeColors &table = shadeColors.back();
+    table.color = drawColor;
+    for (int i = 0; i < raster::SHADE_LUT_SIZE; ++i)
+    {
+        table.entries[i].foreground = color::scale(drawColor.foreground, i / (raster::SHADE_LUT_SIZE - 1.f));
+        table.entries[i].background = drawColor.background;
+    }
+
+    return table.entries;
+}
+void Renderer::rasterize(const raster::Triangle &t, raster::Span span, raster::SpanKernel kernel, int minX, int minY, int maxX, int maxY)
+{
+    int count = maxX - minX + 1;
+
+    // Edge values at the first cell of the region
+    span.w0 = t.w0 + (minX - t.minX) * t.stepX0 + (minY - t.minY) * t.stepY0;
+    span.w1 = t.w1 + (minX - t.minX) * t.stepX1 + (minY - t.minY) * t.stepY1;
+    span.w2 = t.w2 + (minX - t.minX) * t.stepX2 + (minY - t.minY) * t.stepY2;
+
+    Framebuffer *target = getTarget();
+    bool colored = target->hasPlane(Framebuffer::COLOR);
+
+    // Shade the region one row at a time, straight into the framebuffer
+    for (int y = minY; y <= maxY; ++y)
+    {
+        kernel(span, count, target->glyphRow(y) + minX, target->depthRow(y) + minX,
+               colored ? target->colorRow(y) + minX : nullptr);
+
+        span.w0 += t.stepY0;
+        span.w1 += t.stepY1;
+        span.w2 += t.stepY2;
+    }
+}
+bool Renderer::addLight(const Light &light)
+{
+    if (lightCount == raster::MAX_LIGHTS)
+        return false;
+
+    Light &added = lights[lightCount++];
+    added = light;
+
+    if (light.type == LightType::Point)
+        hasPointLights = true;
+    else if (light.direction.length() > 0.f)
+        added.direction = light.direction.normalize();
+
+    return true;
+}
+void Renderer::clearLights()
+{
+    lightCount = 0;
+    hasPointLights = false;
+}
+bool Renderer::setShadeRamp(const wchar_t *ramp)
+{
+    int count = static_cast<int>(std::wcslen(ramp));
+    if (count == 0)
+        return false;
+
+    // Rebuild the palette from the background, the line fill (keeping their indices) and the
+    // new ramp, so switching ramps does not pile up the glyphs of the old ones
+    GlyphPalette rebuilt;
+    rebuilt.add(palette.getCharacter(background));
+    rebuilt.add(palette.getCharacter(fill));
+
+    bool added = true;
+    std::vector<Glyph> glyphs(count);
+    for (int i = 0; i < count && added; ++i)
+    {
+        glyphs[i] = rebuilt.add(ramp[i]);
+        added = rebuilt.getCharacter(glyphs[i]) == ramp[i];
+    }
+
+    if (!added)
+        return false;
+
+    // The present thread resolves glyphs through the palette, pause it while replacing it
+    // (the glyphs it last presented may mean other characters now)
+    updatePresenter([&]
+                    {
+        palette = rebuilt;
+        presenter.invalidate(); });
+
+    // Spread the ramp evenly over the table (with 4 glyphs, the thresholds of Light::getShade)
+    for (int i = 0; i < raster::SHADE_LUT_SIZE; ++i)
+        shades[i] = glyphs[i * count / raster::SHADE_LUT_SIZE];
+
+    return true;
+}
+void Renderer::setTiledRendering(bool enabled, int threadCount)
+{
+    delete scheduler;
+    scheduler = nullptr;
+
+    binnedTriangles.clear();
+    tileBins.clear();
+
+    if (!enabled)
+        return;
+
+    if (threadCount <= 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    scheduler = new TaskScheduler(threadCount);
+
+    tilesX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+    tilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    tileBins.resize(tilesX * tilesY);
+}
+void Renderer::flushTiles()
+{
+    // Tiles cover disjoint parts of the framebuffer, so they need no locking
+    scheduler->run(tilesX * tilesY, [this](int tile)
+                   { rasterizeTile(tile); });
+
+    binnedTriangles.clear();
+    for (std::vector<int> &bin : tileBins)
+        bin.clear();
+    shadeColors.clear();
+}
+void Renderer::rasterizeTile(int tile)
+{
+    const std::vector<int> &bin = tileBins[tile];
+    if (bin.empty())
+        return;
+
+    int tileMinX = (tile % tilesX) * TILE_WIDTH;
+    int tileMinY = (tile / tilesX) * TILE_HEIGHT;
+    int tileMaxX = std::min(tileMinX + TILE_WIDTH, width) - 1;
+    int tileMaxY = std::min(tileMinY + TILE_HEIGHT, height) - 1;
+
+    // Triangles are stored in submission order, so overlaps resolve as in immediate mode
+    for (int index : bin)
+    {
+        const BinnedTriangle &binned = binnedTriangles[index];
+        const raster::Triangle &t = binned.triangle;
+
+        rasterize(t, binned.span, binned.kernel,
+                  std::max(t.minX, tileMinX), std::max(t.minY, tileMinY),
+                  std::min(t.maxX, tileMaxX), std::min(t.maxY, tileMaxY));
+    }
+}
+void Renderer::transformVertices(const Vertex *vertices, int verticesCount, const fMat4 &transform, const fMat4 *normalTransform, ScreenVertex *out) const
+{
+    // Vertex stage: project each vertex exactly once per draw
+    for (int i = 0; i < verticesCount; ++i)
+    {
+        clipToScreen(transform * fVec4(vertices[i].position, 1.f), out[i]);
+
+        // Bring the normal into world space (the raster stage normalizes it again)
+        if (normalTransform)
+            out[i].normals = (*normalTransform * fVec4(vertices[i].normals, 0.f)).xyz();
+        else
+            out[i].normals = vertices[i].normals;
+    }
+}
+void Renderer::transformVertices(const VertexBuffer &vertices, const fMat4 &transform, const fMat4 *normalTransform, ScreenVertex *out) const
+{
+    // Vertex stage over whole batches of vertices
+    transform::Batch batch = {transform, normalTransform, static_cast<float>(width), static_cast<float>(height)};
+    transformKernel(batch, vertices, 0, vertices.getCount(), out);
+}
+void Renderer::assembleTriangles(const int *indices, int indiciesCount, const ScreenVertex *vertices, const VertexSource &source)
+{
+    const float guard = raster::GUARD_BAND * .5f;
+
+    // Primitive stage: iterate over all triangles (each triangle has 3 indices)
+    for (int i = 0; i + 2 < indiciesCount; i += 3)
+    {
+        const ScreenVertex &v0 = vertices[indices[i]];
+        const ScreenVertex &v1 = vertices[indices[i + 1]];
+        const ScreenVertex &v2 = vertices[indices[i + 2]];
+
+        // Vertices rejected by the vertex stage (zeroed, invW 0) are outside the near or far
+        // plane, and vertices past the guard band would overflow the rasterizer: only those
+        // triangles go through the clipper, the rest only have their bounding box clamped
+        if (v0.invW == 0.f || v1.invW == 0.f || v2.invW == 0.f ||
+            std::fabs(v0.position.x) > guard || std::fabs(v0.position.y) > guard ||
+            std::fabs(v1.position.x) > guard || std::fabs(v1.position.y) > guard ||
+            std::fabs(v2.position.x) > guard || std::fabs(v2.position.y) > guard)
+        {
+            clipTriangle(indices + i, vertices, source);
+            continue;
+        }
+
+        tri(v0, v1, v2);
+    }
+}
+void Renderer::clipTriangle(const int *indices, const ScreenVertex *vertices, const VertexSource &source)
+{
+    // The vertex stage keeps no clip-space positions, recompute them for this triangle
+    clip::Vertex polygon[clip::MAX_POLYGON];
+    unsigned inside = ~0u, crossed = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        int index = indices[i];
+        fVec3 position = source.vertexBuffer ? source.vertexBuffer->get(index).position : source.vertices[index].position;
+
+        polygon[i].position = *source.transform * fVec4(position, 1.f);
+        polygon[i].normals = vertices[index].normals;
+
+        unsigned outcode = clip::getOutcode(polygon[i].position, guardBand);
+        inside &= outcode;
+        crossed |= outcode;
+    }
+
+    // Entirely outside one plane
+    if (inside)
+        return;
+
+    // Only clip against the planes the triangle crosses
+    int count = clip::clipPolygon(polygon, 3, crossed, guardBand);
+    if (count < 3)
+        return;
+
+    // Fan of the clipped polygon, with the winding of the triangle
+    ScreenVertex screen[clip::MAX_POLYGON];
+    for (int i = 0; i < count; ++i)
+    {
+        projectToScreen(polygon[i].position, screen[i]);
+        screen[i].normals = polygon[i].normals;
+    }
+
+    for (int i = 1; i + 1 < count; ++i)
+        tri(screen[0], screen[i], screen[i + 1]);
+}
+void Renderer::createProjectionMatrix(float fov, float near, float far)
+{
+    // Create a perspective projection matrix
+    setProjectionMatrix(fMat4::perspective(fov, static_cast<float>(width) / height, near, far));
+}
+void Renderer::createViewMatrix(float camX, float camY, float camZ)
+{
+    // Create a view matrix
+    setCamera({camX, camY, camZ});
+}
+
+void Renderer::setProjectionMatrix(const fMat4 &projection)
+{
+    projectionMatrix = projection;
+    viewProjectionDirty = modelViewProjectionDirty = inverseViewProjectionDirty = frustumDirty = true;
+}
+void Renderer::setViewMatrix(const fMat4 &view)
+{
+    viewMatrix = view;
+    viewProjectionDirty = modelViewProjectionDirty = inverseViewProjectionDirty = frustumDirty = true;
+}
+void Renderer::setCamera(fVec3 position)
+{
+    setViewMatrix(fMat4::translation(position * -1.f));
+}
+void Renderer::lookAt(fVec3 eye, fVec3 target, fVec3 up)
+{
+    setViewMatrix(fMat4::lookAt(eye, target, up));
+}
+void Renderer::setModelMatrix(const fMat4 &model)
+{
+    modelMatrix = model;
+    normalMatrix = model.inverse().transpose();
+    hasModelMatrix = true;
+    modelViewProjectionDirty = true;
+}
+void Renderer::resetModelMatrix()
+{
+    // Without a model matrix the vertex stage uses the view-projection directly
+    hasModelMatrix = false;
+}
+
+const fMat4 &Renderer::getViewProjectionMatrix()
+{
+    if (viewProjectionDirty)
+    {
+        viewProjectionMatrix = projectionMatrix * viewMatrix;
+        viewProjectionDirty = false;
+    }
+
+    return viewProjectionMatrix;
+}
+const fMat4 &Renderer::getModelViewProjectionMatrix()
+{
+    if (!hasModelMatrix)
+        return getViewProjectionMatrix();
+
+    if (modelViewProjectionDirty)
+    {
+        modelViewProjectionMatrix = getViewProjectionMatrix() * modelMatrix;
+        modelViewProjectionDirty = false;
+    }
+
+    return modelViewProjectionMatrix;
+}
+fVec3 Renderer::screenToWorld(const ScreenVertex &vertex)
+{
+    if (inverseViewProjectionDirty)
+    {
+        inverseViewProjectionMatrix = getViewProjectionMatrix().inverse();
+        inverseViewProjectionDirty = false;
+    }
+
+    // Undo the viewport transform and the perspective divide, then the view projection
+    float w = 1.f / vertex.invW;
+    fVec4 clipPos((vertex.position.x / width * 2.f - 1.f) * w,
+                  (1.f - vertex.position.y / height * 2.f) * w,
+                  vertex.depth * w, w);
+
+    fVec4 world = inverseViewProjectionMatrix * clipPos;
+    return world.xyz() * (1.f / world.w);
+}
+const Frustum &Renderer::getFrustum()
+{
+    if (frustumDirty)
+    {
+        frustum = Frustum(getViewProjectionMatrix());
+        frustumDirty = false;
+    }
+
+    return frustum;
+}
+
+iVec2 Renderer::worldToScreen(const fVec3 &worldPos, const fMat4 &transform)
+{
+    // Convert world space to screen space
+    ScreenVertex screenVertex;
+    clipToScreen(transform * fVec4(worldPos, 1.f), screenVertex);
+
+    return iVec2(screenVertex.position.x, screenVertex.position.y);
+}
+void Renderer::projectToScreen(const fVec4 &clipPos, ScreenVertex &screenVertex) const
+{
+    // Perspective divide and viewport transform of a clipped vertex (w > 0); the depth is
+    // clamped since rounding can leave it just outside [0, 1]
+    float invW = 1.f / clipPos.w;
+
+    screenVertex.position.x = (clipPos.x * invW + 1.f) * .5f * width;
+    screenVertex.position.y = (1.f - clipPos.y * invW) * .5f * height;
+    screenVertex.depth = std::min(std::max(clipPos.z * invW, 0.f), 1.f);
+    screenVertex.invW = invW;
+}
+void Renderer::clipToScreen(const fVec4 &clipPos, ScreenVertex &screenVertex) const
+{
+    screenVertex.position = fVec2();
+    screenVertex.depth = 0.f;
+    screenVertex.invW = 0.f;
+
+    if (clipPos.w == 0)
+        return;
+
+    // Perspective divide
+    float invW = 1.f / clipPos.w;
+    float depth = clipPos.z * invW;
+
+    if (depth < 0.f || depth > 1.f)
+        return;
+
+    // Viewport transform
+    screenVertex.position.x = (clipPos.x * invW + 1.f) * .5f * width;
+    screenVertex.position.y = (1.f - clipPos.y * invW) * .5f * height;
+    screenVertex.depth = depth;
+    screenVertex.invW = invW;
+}
@@ -1,44 +1,391 @@
-#pragma once
-
-#include <algorithm>
-#include <chrono>
-
-#include "console.h"
-#include "math.h"
-#include "vertex.h"
-#include "mesh.h"
-#include "light.h"
-
-class Renderer
-{
-public:
-    Renderer(int width, int height);
-    ~Renderer();
-
-    void begin();
-    void draw(Vertex *vertices, int *indices, int indiciesCount);
-    void draw(Mesh &mesh);
-    void render();
-
-    void createProjectionMatrix(float fov, float near, float far);
-    void createViewMatrix(float camX, float camY, float camZ);
-
-private:
-    wchar_t background = ' ', fill = 0x2588;
-    int width, height;
-
-    wchar_t *screen;
-    wchar_t **backBuffer;
-
-    fMat viewMatrix = fMat::identity(4);
-    fMat projectionMatrix = fMat::identity(4);
-
-    void set(iVec2 pos);
-    void line(iVec2 start, iVec2 end);
-    void line(fVec3 start, fVec3 end);
-    void tri(Vertex *vertices, int *indices);
-
-    iVec2 worldToScreen(const fVec3 &worldPos);
-
-    void displayFPS(float fps);
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cwchar>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include "console.h"
+#include "math.h"
+#include "vertex.h"
+#include "mesh.h"
+#include "bounds.h"
+#include "light.h"
+#include "raster.h"
+#include "clip.h"
+#include "transform.h"
+#include "vertexbuffer.h"
+#include "scheduler.h"
+#include "framebuffer.h"
+#include "presenter.h"
+#include "subcell.h"
+#include "profiler.h"
+
+// Where finished frames go
+enum class RenderTarget
+{
+    Console,  // Take over the terminal on stdout and present every frame there
+    Offscreen // Leave the terminal alone; frames stay in memory unless an output is set
+};
+
+class Renderer
+{
+public:
+    // A frame of width x height glyph cells, each written twice across. The sub-cell modes fill
+    // the same terminal area with 2x2 (HalfBlock) or 4x4 (Braille) times as many pixels.
+    Renderer(int width, int height, RenderTarget target = RenderTarget::Console, CellMode cellMode = CellMode::Shaded);
+    ~Renderer();
+
+    void begin();
+    void draw(const Vertex *vertices, const int *indices, int indiciesCount);
+    void draw(const Vertex *vertices, int verticesCount, const int *indices, int indiciesCount);
+    void draw(const VertexBuffer &vertices, const int *indices, int indiciesCount);
+    void draw(const Mesh &mesh);
+
+    // Draw count instances of a mesh sharing its vertices and indices; instance i is placed by
+    // transforms[i], applied after the mesh transform. Instances are culled one by one and
+    // their vertex stages run in parallel when tiled rendering is enabled.
+    void drawInstanced(const Mesh &mesh, const fMat4 *transforms, int count);
+    void render();
+
+    void createProjectionMatrix(float fov, float near, float far);
+    void createViewMatrix(float camX, float camY, float camZ);
+
+    // Camera and model transforms (the combined matrices are rebuilt lazily)
+    void setProjectionMatrix(const fMat4 &projection);
+    void setViewMatrix(const fMat4 &view);
+    void setCamera(fVec3 position);
+    void lookAt(fVec3 eye, fVec3 target, fVec3 up = fVec3(0, 1, 0));
+    void setModelMatrix(const fMat4 &model);
+    void resetModelMatrix();
+
+    inline const fMat4 &getViewMatrix() const
+    {
+        return viewMatrix;
+    }
+    inline const fMat4 &getProjectionMatrix() const
+    {
+        return projectionMatrix;
+    }
+    const fMat4 &getViewProjectionMatrix();
+
+    // Raster kernels used for triangles that fit the SIMD range (defaults to the widest supported)
+    inline void setSpanKernels(const raster::SpanKernels &kernels)
+    {
+        spanKernels = &kernels;
+    }
+    inline const raster::SpanKernels &getSpanKernels() const
+    {
+        return *spanKernels;
+    }
+
+    // Shading of the following draws (PerCell by default); Flat and Gouraud light triangles
+    // or vertices instead of cells, which is far cheaper
+    inline void setShadingMode(raster::ShadingMode mode)
+    {
+        shadingMode = mode;
+    }
+    inline raster::ShadingMode getShadingMode() const
+    {
+        return shadingMode;
+    }
+
+    // Lights of the following draws, up to raster::MAX_LIGHTS (one directional light towards +z
+    // by default). Point lights are resolved per vertex with Gouraud shading and per triangle
+    // otherwise. Returns false if the lights are full.
+    bool addLight(const Light &light);
+    void clearLights();
+    inline void setAmbientLight(float intensity)
+    {
+        ambientLight = intensity;
+    }
+
+    // Characters that light intensities map to, darkest first and of any length (the block
+    // shades by default). Returns false if the ramp is empty or does not fit in the palette.
+    bool setShadeRamp(const wchar_t *ramp);
+
+    // Color of the cells covered by the following draws (the terminal's default colors
+    // initially), the foreground darkened by the light intensity through the shade lookup
+    // table; only kept when color output is enabled
+    inline void setColor(const color::CellColor &color)
+    {
+        drawColor = color;
+    }
+    inline void setColor(color::Rgb foreground, color::Rgb background = color::DEFAULT)
+    {
+        drawColor.foreground = foreground;
+        drawColor.background = background;
+    }
+
+    // Color output (None by default): every cell keeps the color it was drawn with and the
+    // presenter quantizes it to depth, only writing an escape where the color changes.
+    // Call between frames, it reallocates the framebuffers.
+    void setColorDepth(color::Depth depth);
+    inline color::Depth getColorDepth() const
+    {
+        return presenter.getColorDepth();
+    }
+
+    // Backface culling of the following draws (enabled by default); without it backfacing
+    // triangles are drawn too, lit from their other side
+    inline void setBackfaceCulling(bool enabled)
+    {
+        backfaceCulling = enabled;
+    }
+
+    // Batch kernel of the vertex stage for vertex buffers (defaults to the widest supported)
+    inline void setTransformKernel(transform::TransformKernel kernel)
+    {
+        transformKernel = kernel;
+    }
+    inline transform::TransformKernel getTransformKernel() const
+    {
+        return transformKernel;
+    }
+
+    // Frustum culling of meshes by their bounds before any vertex work (enabled by default)
+    inline void setFrustumCulling(bool enabled)
+    {
+        frustumCulling = enabled;
+    }
+    inline int getCulledMeshes() const
+    {
+        return culledMeshes;
+    }
+
+    // Depth testing of the following draws against the per-cell depth buffer (enabled by default)
+    inline void setDepthTest(bool enabled)
+    {
+        depthTest = enabled;
+    }
+
+    // Present mode (Full by default)
+    void setPresentMode(PresentMode mode);
+    inline PresentMode getPresentMode() const
+    {
+        return presenter.getMode();
+    }
+
+    // Asynchronous presentation: render() hands the frame to a present thread and returns
+    // immediately; frames the terminal cannot keep up with are dropped
+    void setAsyncPresent(bool enabled);
+    inline bool isAsyncPresent() const
+    {
+        return asyncPresenter != nullptr;
+    }
+    inline unsigned getDroppedFrames() const
+    {
+        return asyncPresenter ? asyncPresenter->getDroppedFrames() : 0;
+    }
+
+    // Send presented frames to a file descriptor or a sink instead of stdout
+    // (an Offscreen renderer starts presenting once an output is set)
+    void setOutput(int fd);
+    void setOutput(FrameSink sink);
+
+    // The frame being drawn; between render() and the next begin() it holds the finished
+    // frame, unless presentation is asynchronous. In the sub-cell modes it holds the packed
+    // cells, filled by render().
+    inline const Framebuffer &getFramebuffer() const
+    {
+        return *framebuffer;
+    }
+    inline const GlyphPalette &getPalette() const
+    {
+        return cellMode == CellMode::Shaded ? palette : cellPalette;
+    }
+    inline CellMode getCellMode() const
+    {
+        return cellMode;
+    }
+
+    // Per-stage profiling (disabled by default); the overlay shows the p50/p99 of every
+    // stage next to the FPS counter
+    void setProfiling(bool enabled, bool overlay = false);
+    inline Profiler &getProfiler()
+    {
+        return profiler;
+    }
+
+    // Tiled rendering: triangles are binned into screen tiles during draw() and the tiles
+    // are rasterized in parallel by render() (threadCount 0 uses every hardware thread)
+    void setTiledRendering(bool enabled, int threadCount = 0);
+    inline bool isTiledRendering() const
+    {
+        return scheduler != nullptr;
+    }
+
+    // Tile size in cells
+    static const int TILE_WIDTH = 32;
+    static const int TILE_HEIGHT = 16;
+
+private:
+    // Gives the benchmarks access to the pipeline stages
+    friend struct RendererBench;
+
+    // Size of the rasterized frame in pixels, and of the presented frame in cells (the same
+    // in Shaded mode)
+    int width, height;
+    CellMode cellMode;
+    int columns, rows;
+
+    // Characters of the glyph indices stored in the framebuffers, and of the packed cells
+    // in the sub-cell modes
+    GlyphPalette palette, cellPalette;
+    Glyph background, fill;
+
+    // Intensity to glyph lookup table, filled from the shade ramp, and to pixel level for the
+    // sub-cell modes
+    Glyph shades[raster::SHADE_LUT_SIZE];
+    Glyph levels[raster::SHADE_LUT_SIZE];
+
+    Light lights[raster::MAX_LIGHTS];
+    int lightCount = 0;
+    bool hasPointLights = false;
+    float ambientLight = 0.f;
+
+    // Glyphs, colors (with color output) and depth (normalized device depth of the closest
+    // fragment) of the frame being drawn, one of the three frames (the other two only exist
+    // for asynchronous presentation)
+    Framebuffer *framebuffer;
+    Framebuffer *frames[3] = {};
+    int framePlanes = Framebuffer::GLYPH | Framebuffer::DEPTH;
+    bool depthTest = true;
+
+    // Sub-cell modes: pixel levels, colors and depth of the frame being drawn, packed into
+    // framebuffer by render()
+    Framebuffer *pixels = nullptr;
+
+    color::CellColor drawColor;
+
+    // Intensity to cell color lookup table of one draw color
+    struct ShadeColors
+    {
+        color::CellColor color;
+        color::CellColor entries[raster::SHADE_LUT_SIZE];
+    };
+
+    // Tables of the draw colors used since the tile bins were last emptied, the current one
+    // last (a deque, so binned spans keep pointing at theirs)
+    std::deque<ShadeColors> shadeColors;
+
+    Presenter presenter;
+    AsyncPresenter *asyncPresenter = nullptr;
+    bool presenting;
+
+    Profiler profiler;
+
+    // Frames rendered since fpsTime, and the rate over the last full second
+    std::chrono::steady_clock::time_point fpsTime = std::chrono::steady_clock::now();
+    int fpsFrames = 0;
+    float fps = 0.f;
+
+    const raster::SpanKernels *spanKernels;
+    raster::ShadingMode shadingMode = raster::ShadingMode::PerCell;
+    bool backfaceCulling = true;
+    transform::TransformKernel transformKernel;
+
+    // Triangle set up by the primitive stage, waiting in the tile bins with the kernel of its draw
+    struct BinnedTriangle
+    {
+        raster::Triangle triangle;
+        raster::Span span;
+        raster::SpanKernel kernel;
+    };
+
+    TaskScheduler *scheduler = nullptr;
+    int tilesX = 0, tilesY = 0;
+    std::vector<BinnedTriangle> binnedTriangles;
+    std::vector<std::vector<int>> tileBins;
+
+    fMat4 viewMatrix = fMat4::identity();
+    fMat4 projectionMatrix = fMat4::identity();
+    fMat4 modelMatrix = fMat4::identity();
+    fMat4 normalMatrix = fMat4::identity();
+
+    // Cached products, only recomputed when one of their factors changes
+    fMat4 viewProjectionMatrix = fMat4::identity();
+    fMat4 modelViewProjectionMatrix = fMat4::identity();
+    fMat4 inverseViewProjectionMatrix = fMat4::identity();
+    bool viewProjectionDirty = false, modelViewProjectionDirty = false, inverseViewProjectionDirty = false;
+    bool hasModelMatrix = false;
+
+    // Clip volume of the view projection matrix, rebuilt with it
+    Frustum frustum;
+    bool frustumDirty = true;
+    bool frustumCulling = true;
+
+    // Meshes and instances rejected by frustum culling since begin()
+    int culledMeshes = 0;
+
+    // Screen-space vertices written by the vertex stage, reused between draws
+    std::vector<ScreenVertex> screenVertices;
+
+    // Screen-edge planes beyond which triangles are clipped rather than clamped
+    clip::GuardBand guardBand;
+
+    // Vertices of a draw, to recompute the clip-space positions of triangles that need clipping
+    struct VertexSource
+    {
+        const Vertex *vertices;
+        const VertexBuffer *vertexBuffer;
+        const fMat4 *transform;
+    };
+
+    // Clip-space and normal transforms of the visible instances of drawInstanced
+    struct Instance
+    {
+        fMat4 transform, normalTransform;
+    };
+    std::vector<Instance> instances;
+
+    // Frame the drawing stages write to
+    inline Framebuffer *getTarget() const
+    {
+        return pixels ? pixels : framebuffer;
+    }
+
+    void set(iVec2 pos);
+    void line(iVec2 start, iVec2 end);
+    void line(fVec3 start, fVec3 end);
+    void tri(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2);
+    void setupTriangle(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2);
+
+    // Ambient plus every light reaching a world position, clamped to [0, 1]
+    float lightIntensity(const fVec3 &normal, const fVec3 &position) const;
+
+    // Shade colors of drawColor, built on its first use
+    const color::CellColor *getShadeColors();
+    void rasterize(const raster::Triangle &t, raster::Span span, raster::SpanKernel kernel, int minX, int minY, int maxX, int maxY);
+
+    // Apply a presenter setting, pausing the present thread (which owns the presenter) meanwhile
+    template <typename Update>
+    void updatePresenter(Update update);
+
+    void flushTiles();
+    void rasterizeTile(int tile);
+
+    // Draw interleaved vertices, or the vertex buffer if it is not null
+    void drawTransformed(const Vertex *vertices, const VertexBuffer *vertexBuffer, int verticesCount,
+                         const int *indices, int indiciesCount,
+                         const fMat4 &transform, const fMat4 *normalTransform);
+
+    // Vertex stage into out[0..verticesCount), safe to run for several draws in parallel
+    void transformVertices(const Vertex *vertices, int verticesCount, const fMat4 &transform, const fMat4 *normalTransform, ScreenVertex *out) const;
+    void transformVertices(const VertexBuffer &vertices, const fMat4 &transform, const fMat4 *normalTransform, ScreenVertex *out) const;
+    void assembleTriangles(const int *indices, int indiciesCount, const ScreenVertex *vertices, const VertexSource &source);
+    void clipTriangle(const int *indices, const ScreenVertex *vertices, const VertexSource &source);
+
+    const fMat4 &getModelViewProjectionMatrix();
+    const Frustum &getFrustum();
+
+    // World position of a screen vertex, through the inverse view projection
+    fVec3 screenToWorld(const ScreenVertex &vertex);
+
+    iVec2 worldToScreen(const fVec3 &worldPos, const fMat4 &transform);
+    void clipToScreen(const fVec4 &clipPos, ScreenVertex &screenVertex) const;
+    void projectToScreen(const fVec4 &clipPos, ScreenVertex &screenVertex) const;
+
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "scheduler.h"
+
+TaskScheduler::TaskScheduler(int threadCount)
+    : queues(std::max(1, threadCount)), remaining(0)
+{
+    for (int i = 1; i < threadCount; ++i)
+        workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void TaskScheduler::run(int count, const std::function<void(int)> &task)
+{
+    if (count <= 0)
+        return;
+
+    // Single-threaded pool, nothing to distribute
+    if (workers.empty())
+    {
+        for (int i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Deal the tasks round-robin over all queues
+        for (int i = 0; i < count; ++i)
+        {
+            Queue &queue = queues[i % queues.size()];
+            std::lock_guard<std::mutex> queueLock(queue.mutex);
+            queue.tasks.push_back(i);
+        }
+
+        this->task = &task;
+        remaining = count;
+        ++generation;
+    }
+    wake.notify_all();
+
+    // The calling thread works too (it owns queue 0)
+    work(0, task);
+
+    // Wait until every task is finished and no worker is still looking at the queues
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]
+              { return remaining == 0 && activeWorkers == 0; });
+    this->task = nullptr;
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    unsigned seen = 0;
+
+    for (;;)
+    {
+        const std::function<void(int)> *current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]
+                      { return stopping || (generation != seen && task); });
+
+            if (stopping)
+                return;
+
+            seen = generation;
+            current = task;
+            ++activeWorkers;
+        }
+
+        work(index, *current);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+        }
+        done.notify_all();
+    }
+}
+
+void TaskScheduler::work(int index, const std::function<void(int)> &task)
+{
+    int taskIndex;
+    while (pop(index, taskIndex))
+    {
+        task(taskIndex);
+
+        if (--remaining == 0)
+        {
+            // Take the lock so the notification cannot slip in before the waiter sleeps
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+bool TaskScheduler::pop(int index, int &taskIndex)
+{
+    // Own queue first (newest task)
+    {
+        Queue &own = queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            taskIndex = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another queue
+    for (size_t i = 1; i < queues.size(); ++i)
+    {
+        Queue &victim = queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            taskIndex = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads running batches of indexed tasks with work stealing.
+// Every thread owns a queue; it pops its own tasks from the back and, once empty,
+// steals from the front of the other queues.
+class TaskScheduler
+{
+public:
+    // threadCount includes the calling thread, which takes part in every batch
+    explicit TaskScheduler(int threadCount);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    // Run task(i) for every i in [0, count) and wait for all of them to finish
+    void run(int count, const std::function<void(int)> &task);
+
+    inline int getThreadCount() const
+    {
+        return static_cast<int>(workers.size()) + 1;
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Queue> queues;
+
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(int)> *task = nullptr;
+    unsigned generation = 0;
+    int activeWorkers = 0;
+    bool stopping = false;
+
+    std::atomic<int> remaining;
+
+    void workerLoop(int index);
+    void work(int index, const std::function<void(int)> &task);
+    bool pop(int index, int &taskIndex);
+};
@@ -0,0 +1,155 @@
+#include "subcell.h"
+
+namespace
+{
+    // 4x4 Bayer matrix scaled to pixel levels: level > threshold turns a pixel on, so level 0
+    // never does and FULL_LEVEL always does
+    const Glyph THRESHOLDS[4][4] = {
+        {8, 136, 40, 168},
+        {200, 72, 232, 104},
+        {56, 184, 24, 152},
+        {248, 120, 216, 88}};
+
+    // Pixel of each braille mask bit within its cell
+    const int BRAILLE_X[8] = {0, 0, 0, 1, 1, 1, 0, 1};
+    const int BRAILLE_Y[8] = {0, 1, 2, 0, 1, 2, 3, 3};
+
+    // Half block glyphs (the glyph is the mask: bit 0 is the upper pixel, bit 1 the lower one)
+    const Glyph UPPER_HALF = 1;
+
+    void packHalfBlocks(const Framebuffer &pixels, Framebuffer &cells)
+    {
+        bool colored = pixels.hasPlane(Framebuffer::COLOR) && cells.hasPlane(Framebuffer::COLOR);
+
+        for (int y = 0; y < cells.getHeight(); ++y)
+        {
+            const Glyph *upper = pixels.glyphRow(2 * y);
+            const Glyph *lower = pixels.glyphRow(2 * y + 1);
+            const Glyph *upperThresholds = THRESHOLDS[(2 * y) & 3];
+            const Glyph *lowerThresholds = THRESHOLDS[(2 * y + 1) & 3];
+
+            Glyph *out = cells.glyphRow(y);
+            for (int x = 0; x < cells.getWidth(); ++x)
+                out[x] = static_cast<Glyph>((upper[x] > upperThresholds[x & 3]) | (lower[x] > lowerThresholds[x & 3]) << 1);
+
+            if (!colored)
+                continue;
+
+            const color::CellColor *upperColors = pixels.colorRow(2 * y);
+            const color::CellColor *lowerColors = pixels.colorRow(2 * y + 1);
+            color::CellColor *colors = cells.colorRow(y);
+
+            for (int x = 0; x < cells.getWidth(); ++x)
+            {
+                color::CellColor cell;
+                if (out[x] == 2)
+                    cell.foreground = lowerColors[x].foreground;
+                else if (out[x] != 0)
+                    cell.foreground = upperColors[x].foreground;
+
+                // Two colors in one cell: the upper half in the foreground, the lower in the background
+                if (out[x] == 3 && lowerColors[x].foreground != cell.foreground)
+                {
+                    cell.background = lowerColors[x].foreground;
+                    out[x] = UPPER_HALF;
+                }
+
+                colors[x] = cell;
+            }
+        }
+    }
+
+    // Dot mask of the braille cell whose left pixel is column px of the four rows. Phase is
+    // px & 3, a template argument so the thresholds are constants.
+    template <int Phase>
+    inline Glyph brailleCell(const Glyph *const rows[4], int px)
+    {
+        // Dots 1-3 and 7 down the left column, 4-6 and 8 down the right one
+        return static_cast<Glyph>(
+            (rows[0][px] > THRESHOLDS[0][Phase]) | (rows[1][px] > THRESHOLDS[1][Phase]) << 1 |
+            (rows[2][px] > THRESHOLDS[2][Phase]) << 2 | (rows[3][px] > THRESHOLDS[3][Phase]) << 6 |
+            (rows[0][px + 1] > THRESHOLDS[0][Phase + 1]) << 3 | (rows[1][px + 1] > THRESHOLDS[1][Phase + 1]) << 4 |
+            (rows[2][px + 1] > THRESHOLDS[2][Phase + 1]) << 5 | (rows[3][px + 1] > THRESHOLDS[3][Phase + 1]) << 7);
+    }
+
+    void packBraille(const Framebuffer &pixels, Framebuffer &cells)
+    {
+        bool colored = pixels.hasPlane(Framebuffer::COLOR) && cells.hasPlane(Framebuffer::COLOR);
+
+        for (int y = 0; y < cells.getHeight(); ++y)
+        {
+            // Four pixel rows per cell row, two pixels of each per cell; two cells per step cover
+            // a whole period of the dither pattern
+            const Glyph *rows[4] = {pixels.glyphRow(4 * y), pixels.glyphRow(4 * y + 1),
+                                    pixels.glyphRow(4 * y + 2), pixels.glyphRow(4 * y + 3)};
+
+            Glyph *out = cells.glyphRow(y);
+            int x = 0;
+            for (; x + 1 < cells.getWidth(); x += 2)
+            {
+                out[x] = brailleCell<0>(rows, 2 * x);
+                out[x + 1] = brailleCell<2>(rows, 2 * x + 2);
+            }
+            if (x < cells.getWidth())
+                out[x] = brailleCell<0>(rows, 2 * x);
+
+            if (!colored)
+                continue;
+
+            color::CellColor *colors = cells.colorRow(y);
+            for (x = 0; x < cells.getWidth(); ++x)
+            {
+                color::CellColor cell;
+                if (out[x])
+                {
+                    int bit = __builtin_ctz(out[x]);
+                    cell.foreground = pixels.colorRow(4 * y + BRAILLE_Y[bit])[2 * x + BRAILLE_X[bit]].foreground;
+                }
+
+                colors[x] = cell;
+            }
+        }
+    }
+}
+
+int subcell::getPixelsX(CellMode mode)
+{
+    return mode == CellMode::Braille ? 2 : 1;
+}
+
+int subcell::getPixelsY(CellMode mode)
+{
+    return mode == CellMode::Braille ? 4 : mode == CellMode::HalfBlock ? 2 : 1;
+}
+
+int subcell::getCellWidth(CellMode mode)
+{
+    return mode == CellMode::Shaded ? 2 : 1;
+}
+
+void subcell::fillPalette(CellMode mode, GlyphPalette &palette)
+{
+    palette = GlyphPalette();
+    palette.add(' ');
+
+    if (mode == CellMode::HalfBlock)
+    {
+        palette.add(0x2580); // Upper Half Block
+        palette.add(0x2584); // Lower Half Block
+        palette.add(0x2588); // Full Block
+    }
+    else if (mode == CellMode::Braille)
+    {
+        // Braille patterns are U+2800 plus their dot mask
+        for (int mask = 1; mask < 256; ++mask)
+            palette.add(static_cast<wchar_t>(0x2800 + mask));
+    }
+}
+
+void subcell::pack(CellMode mode, const Framebuffer &pixels, Framebuffer &cells)
+{
+    if (mode == CellMode::HalfBlock)
+        packHalfBlocks(pixels, cells);
+    else if (mode == CellMode::Braille)
+        packBraille(pixels, cells);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "framebuffer.h"
+
+// How rendered pixels map to terminal cells
+enum class CellMode
+{
+    Shaded,    // One pixel per cell, shaded through the glyph ramp and written twice across
+    HalfBlock, // 1x2 pixels per cell, packed into the upper and lower half block characters
+    Braille    // 2x4 pixels per cell, packed into braille patterns
+};
+
+namespace subcell
+{
+    // Pixels are light levels (0-255, 0 is the background) that packing dithers to on or off
+    const Glyph FULL_LEVEL = 255;
+
+    // Pixels of a cell across and down
+    int getPixelsX(CellMode mode);
+    int getPixelsY(CellMode mode);
+
+    // Terminal columns of a cell: Shaded cells are written twice to come out roughly square,
+    // sub-cell pixels already are
+    int getCellWidth(CellMode mode);
+
+    // Characters of the packed cells, glyph i being the pattern of pixel mask i (a space for
+    // the empty pattern). Replaces the contents of palette.
+    void fillPalette(CellMode mode, GlyphPalette &palette);
+
+    // Pack a frame of pixel levels into cells of a HalfBlock or Braille frame: a pixel is on when
+    // its level beats a 4x4 ordered dither threshold, so lighting survives as dot density. With
+    // color planes on both frames, a cell takes the foreground of its first lit pixel (half
+    // blocks with two lit pixels of different colors use the background for the lower one).
+    void pack(CellMode mode, const Framebuffer &pixels, Framebuffer &cells);
+}
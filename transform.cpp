@@ -0,0 +1,78 @@
+#include "transform.h"
+
+void transform::transformScalar(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out)
+{
+    const float(&m)[4][4] = batch.transform.data;
+
+    const float *px = vertices.getStream(VertexBuffer::POSITION_X) + first;
+    const float *py = vertices.getStream(VertexBuffer::POSITION_Y) + first;
+    const float *pz = vertices.getStream(VertexBuffer::POSITION_Z) + first;
+    const float *nx = vertices.getStream(VertexBuffer::NORMAL_X) + first;
+    const float *ny = vertices.getStream(VertexBuffer::NORMAL_Y) + first;
+    const float *nz = vertices.getStream(VertexBuffer::NORMAL_Z) + first;
+
+    for (int i = 0; i < count; ++i)
+    {
+        ScreenVertex &vertex = out[i];
+
+        // Object space to clip space
+        float x = m[0][0] * px[i] + m[0][1] * py[i] + m[0][2] * pz[i] + m[0][3];
+        float y = m[1][0] * px[i] + m[1][1] * py[i] + m[1][2] * pz[i] + m[1][3];
+        float z = m[2][0] * px[i] + m[2][1] * py[i] + m[2][2] * pz[i] + m[2][3];
+        float w = m[3][0] * px[i] + m[3][1] * py[i] + m[3][2] * pz[i] + m[3][3];
+
+        // Perspective divide and viewport transform
+        float invW = 1.f / w;
+        float depth = z * invW;
+
+        if (w == 0 || depth < 0.f || depth > 1.f)
+        {
+            vertex.position = fVec2();
+            vertex.depth = 0.f;
+            vertex.invW = 0.f;
+        }
+        else
+        {
+            vertex.position.x = (x * invW + 1.f) * .5f * batch.width;
+            vertex.position.y = (1.f - y * invW) * .5f * batch.height;
+            vertex.depth = depth;
+            vertex.invW = invW;
+        }
+
+        // Normals as directions (no translation)
+        if (batch.normalTransform)
+        {
+            const float(&n)[4][4] = batch.normalTransform->data;
+
+            vertex.normals.x = n[0][0] * nx[i] + n[0][1] * ny[i] + n[0][2] * nz[i];
+            vertex.normals.y = n[1][0] * nx[i] + n[1][1] * ny[i] + n[1][2] * nz[i];
+            vertex.normals.z = n[2][0] * nx[i] + n[2][1] * ny[i] + n[2][2] * nz[i];
+        }
+        else
+            vertex.normals = fVec3(nx[i], ny[i], nz[i]);
+    }
+}
+
+transform::TransformKernel transform::selectTransformKernel()
+{
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return transformAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return transformSSE2;
+#endif
+
+    return transformScalar;
+}
+
+const char *transform::getTransformKernelName(TransformKernel kernel)
+{
+    if (kernel == transformAVX2)
+        return "avx2";
+    if (kernel == transformSSE2)
+        return "sse2";
+
+    return "scalar";
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "math.h"
+#include "vertex.h"
+#include "vertexbuffer.h"
+
+namespace transform
+{
+    // Inputs of a batch transform kernel
+    struct Batch
+    {
+        // Object space to clip space
+        fMat4 transform;
+
+        // Applied to the normals (as directions), or null to copy them unchanged
+        const fMat4 *normalTransform;
+
+        // Target size in cells
+        float width, height;
+    };
+
+    // Transforms count vertices of a buffer starting at first, writing out[0..count).
+    // Vertices with w == 0 or a depth outside [0, 1] get a zero position, depth and 1 / w,
+    // like Renderer::clipToScreen.
+    typedef void (*TransformKernel)(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out);
+
+    void transformScalar(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out);
+    void transformSSE2(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out);
+    void transformAVX2(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out);
+
+    // Pick the widest kernel the CPU supports
+    TransformKernel selectTransformKernel();
+    const char *getTransformKernelName(TransformKernel kernel);
+}
@@ -0,0 +1,198 @@
+#include "transform.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+// Both kernels evaluate the same operations in the same order as transformScalar,
+// so they produce identical vertices; only the lane count differs.
+
+namespace
+{
+    // Lanes of one batch, written out as screen vertices
+    struct Lanes
+    {
+        alignas(32) float x[8], y[8], depth[8], invW[8];
+        alignas(32) float nx[8], ny[8], nz[8];
+    };
+
+    inline void scatter(const Lanes &lanes, int count, ScreenVertex *out)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            out[i].position = fVec2(lanes.x[i], lanes.y[i]);
+            out[i].depth = lanes.depth[i];
+            out[i].invW = lanes.invW[i];
+            out[i].normals = fVec3(lanes.nx[i], lanes.ny[i], lanes.nz[i]);
+        }
+    }
+}
+
+__attribute__((target("sse2"))) void transform::transformSSE2(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out)
+{
+    const float(&m)[4][4] = batch.transform.data;
+    __m128 row[4][4];
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            row[r][c] = _mm_set1_ps(m[r][c]);
+
+    __m128 normalRow[3][3];
+    if (batch.normalTransform)
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                normalRow[r][c] = _mm_set1_ps(batch.normalTransform->data[r][c]);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 half = _mm_set1_ps(.5f);
+    const __m128 width = _mm_set1_ps(batch.width), height = _mm_set1_ps(batch.height);
+
+    const float *px = vertices.getStream(VertexBuffer::POSITION_X) + first;
+    const float *py = vertices.getStream(VertexBuffer::POSITION_Y) + first;
+    const float *pz = vertices.getStream(VertexBuffer::POSITION_Z) + first;
+    const float *nx = vertices.getStream(VertexBuffer::NORMAL_X) + first;
+    const float *ny = vertices.getStream(VertexBuffer::NORMAL_Y) + first;
+    const float *nz = vertices.getStream(VertexBuffer::NORMAL_Z) + first;
+
+    Lanes lanes;
+
+    // Streams are padded past the last vertex, so the last batch can be loaded in full
+    for (int i = 0; i < count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(px + i), vy = _mm_loadu_ps(py + i), vz = _mm_loadu_ps(pz + i);
+
+        // Object space to clip space
+        __m128 clip[4];
+        for (int r = 0; r < 4; ++r)
+            clip[r] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(row[r][0], vx), _mm_mul_ps(row[r][1], vy)),
+                                            _mm_mul_ps(row[r][2], vz)),
+                                 row[r][3]);
+
+        // Perspective divide and viewport transform, zeroing rejected vertices
+        __m128 invW = _mm_div_ps(one, clip[3]);
+        __m128 depth = _mm_mul_ps(clip[2], invW);
+        __m128 rejected = _mm_or_ps(_mm_cmpeq_ps(clip[3], zero),
+                                    _mm_or_ps(_mm_cmplt_ps(depth, zero), _mm_cmpgt_ps(depth, one)));
+
+        __m128 sx = _mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(clip[0], invW), one), half), width);
+        __m128 sy = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(clip[1], invW)), half), height);
+
+        _mm_store_ps(lanes.x, _mm_andnot_ps(rejected, sx));
+        _mm_store_ps(lanes.y, _mm_andnot_ps(rejected, sy));
+        _mm_store_ps(lanes.depth, _mm_andnot_ps(rejected, depth));
+        _mm_store_ps(lanes.invW, _mm_andnot_ps(rejected, invW));
+
+        // Normals as directions (no translation)
+        __m128 vnx = _mm_loadu_ps(nx + i), vny = _mm_loadu_ps(ny + i), vnz = _mm_loadu_ps(nz + i);
+        if (batch.normalTransform)
+        {
+            __m128 normal[3];
+            for (int r = 0; r < 3; ++r)
+                normal[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalRow[r][0], vnx), _mm_mul_ps(normalRow[r][1], vny)),
+                                       _mm_mul_ps(normalRow[r][2], vnz));
+
+            vnx = normal[0];
+            vny = normal[1];
+            vnz = normal[2];
+        }
+
+        _mm_store_ps(lanes.nx, vnx);
+        _mm_store_ps(lanes.ny, vny);
+        _mm_store_ps(lanes.nz, vnz);
+
+        scatter(lanes, std::min(4, count - i), out + i);
+    }
+}
+
+__attribute__((target("avx2"))) void transform::transformAVX2(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out)
+{
+    const float(&m)[4][4] = batch.transform.data;
+    __m256 row[4][4];
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            row[r][c] = _mm256_set1_ps(m[r][c]);
+
+    __m256 normalRow[3][3];
+    if (batch.normalTransform)
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                normalRow[r][c] = _mm256_set1_ps(batch.normalTransform->data[r][c]);
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 half = _mm256_set1_ps(.5f);
+    const __m256 width = _mm256_set1_ps(batch.width), height = _mm256_set1_ps(batch.height);
+
+    const float *px = vertices.getStream(VertexBuffer::POSITION_X) + first;
+    const float *py = vertices.getStream(VertexBuffer::POSITION_Y) + first;
+    const float *pz = vertices.getStream(VertexBuffer::POSITION_Z) + first;
+    const float *nx = vertices.getStream(VertexBuffer::NORMAL_X) + first;
+    const float *ny = vertices.getStream(VertexBuffer::NORMAL_Y) + first;
+    const float *nz = vertices.getStream(VertexBuffer::NORMAL_Z) + first;
+
+    Lanes lanes;
+
+    // Streams are padded past the last vertex, so the last batch can be loaded in full
+    for (int i = 0; i < count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(px + i), vy = _mm256_loadu_ps(py + i), vz = _mm256_loadu_ps(pz + i);
+
+        // Object space to clip space
+        __m256 clip[4];
+        for (int r = 0; r < 4; ++r)
+            clip[r] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(row[r][0], vx), _mm256_mul_ps(row[r][1], vy)),
+                                                  _mm256_mul_ps(row[r][2], vz)),
+                                    row[r][3]);
+
+        // Perspective divide and viewport transform, zeroing rejected vertices
+        __m256 invW = _mm256_div_ps(one, clip[3]);
+        __m256 depth = _mm256_mul_ps(clip[2], invW);
+        __m256 rejected = _mm256_or_ps(_mm256_cmp_ps(clip[3], zero, _CMP_EQ_OQ),
+                                       _mm256_or_ps(_mm256_cmp_ps(depth, zero, _CMP_LT_OQ), _mm256_cmp_ps(depth, one, _CMP_GT_OQ)));
+
+        __m256 sx = _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(clip[0], invW), one), half), width);
+        __m256 sy = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(clip[1], invW)), half), height);
+
+        _mm256_store_ps(lanes.x, _mm256_andnot_ps(rejected, sx));
+        _mm256_store_ps(lanes.y, _mm256_andnot_ps(rejected, sy));
+        _mm256_store_ps(lanes.depth, _mm256_andnot_ps(rejected, depth));
+        _mm256_store_ps(lanes.invW, _mm256_andnot_ps(rejected, invW));
+
+        // Normals as directions (no translation)
+        __m256 vnx = _mm256_loadu_ps(nx + i), vny = _mm256_loadu_ps(ny + i), vnz = _mm256_loadu_ps(nz + i);
+        if (batch.normalTransform)
+        {
+            __m256 normal[3];
+            for (int r = 0; r < 3; ++r)
+                normal[r] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalRow[r][0], vnx), _mm256_mul_ps(normalRow[r][1], vny)),
+                                          _mm256_mul_ps(normalRow[r][2], vnz));
+
+            vnx = normal[0];
+            vny = normal[1];
+            vnz = normal[2];
+        }
+
+        _mm256_store_ps(lanes.nx, vnx);
+        _mm256_store_ps(lanes.ny, vny);
+        _mm256_store_ps(lanes.nz, vnz);
+
+        scatter(lanes, std::min(8, count - i), out + i);
+    }
+}
+
+#else
+
+// No SIMD kernels on this architecture, selectTransformKernel never returns these
+void transform::transformSSE2(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out)
+{
+    transformScalar(batch, vertices, first, count, out);
+}
+
+void transform::transformAVX2(const Batch &batch, const VertexBuffer &vertices, int first, int count, ScreenVertex *out)
+{
+    transformScalar(batch, vertices, first, count, out);
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace utf8
+{
+    // Encoded form of one code point
+    struct Sequence
+    {
+        char bytes[4];
+        int length;
+    };
+
+    // Encode a code point (invalid ones become U+FFFD)
+    inline Sequence encode(wchar_t glyph)
+    {
+        uint32_t cp = static_cast<uint32_t>(glyph);
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            cp = 0xFFFD;
+
+        Sequence sequence = {{0, 0, 0, 0}, 0};
+        if (cp < 0x80)
+        {
+            sequence.bytes[0] = static_cast<char>(cp);
+            sequence.length = 1;
+        }
+        else if (cp < 0x800)
+        {
+            sequence.bytes[0] = static_cast<char>(0xC0 | (cp >> 6));
+            sequence.bytes[1] = static_cast<char>(0x80 | (cp & 0x3F));
+            sequence.length = 2;
+        }
+        else if (cp < 0x10000)
+        {
+            sequence.bytes[0] = static_cast<char>(0xE0 | (cp >> 12));
+            sequence.bytes[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            sequence.bytes[2] = static_cast<char>(0x80 | (cp & 0x3F));
+            sequence.length = 3;
+        }
+        else
+        {
+            sequence.bytes[0] = static_cast<char>(0xF0 | (cp >> 18));
+            sequence.bytes[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            sequence.bytes[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            sequence.bytes[3] = static_cast<char>(0x80 | (cp & 0x3F));
+            sequence.length = 4;
+        }
+
+        return sequence;
+    }
+}
@@ -1,9 +1,17 @@
-#pragma once
-
-#include "console.h"
-#include "math.h"
-
-struct Vertex {
-    fVec3 position;
-    fVec3 normals;
+#pragma once
+
+#include "console.h"
+#include "math.h"
+
+struct Vertex {
+    fVec3 position;
+    fVec3 normals;
+};
+
+// Vertex after the vertex stage, projected to screen space
+struct ScreenVertex {
+    fVec2 position; // In cells, with subpixel precision
+    float depth;    // Normalized device depth
+    float invW;     // 1 / clip w, for perspective-correct interpolation
+    fVec3 normals;
 };
\ No newline at end of file
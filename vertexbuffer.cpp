@@ -0,0 +1,58 @@
+#include "vertexbuffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace
+{
+    const int ALIGNMENT = 64;
+}
+
+VertexBuffer::VertexBuffer(int count, int attributeStreams)
+    : count(count), attributeStreams(attributeStreams)
+{
+    // Leave room for a full batch past any vertex and pad every stream to whole cache lines,
+    // so each stays aligned
+    const int floatsPerLine = ALIGNMENT / sizeof(float);
+    capacity = (count + LANES - 1 + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+
+    size_t bytes = static_cast<size_t>(capacity) * getStreamCount() * sizeof(float);
+    void *memory = nullptr;
+    if (posix_memalign(&memory, ALIGNMENT, bytes > 0 ? bytes : 1) != 0)
+        throw std::bad_alloc();
+
+    streams = static_cast<float *>(memory);
+    std::memset(streams, 0, bytes);
+}
+
+VertexBuffer::VertexBuffer(const Vertex *vertices, int count, int attributeStreams)
+    : VertexBuffer(count, attributeStreams)
+{
+    for (int i = 0; i < count; ++i)
+        set(i, vertices[i]);
+}
+
+VertexBuffer::~VertexBuffer()
+{
+    free(streams);
+}
+
+void VertexBuffer::set(int index, const Vertex &vertex)
+{
+    getStream(POSITION_X)[index] = vertex.position.x;
+    getStream(POSITION_Y)[index] = vertex.position.y;
+    getStream(POSITION_Z)[index] = vertex.position.z;
+    getStream(NORMAL_X)[index] = vertex.normals.x;
+    getStream(NORMAL_Y)[index] = vertex.normals.y;
+    getStream(NORMAL_Z)[index] = vertex.normals.z;
+}
+
+Vertex VertexBuffer::get(int index) const
+{
+    Vertex vertex;
+    vertex.position = fVec3(getStream(POSITION_X)[index], getStream(POSITION_Y)[index], getStream(POSITION_Z)[index]);
+    vertex.normals = fVec3(getStream(NORMAL_X)[index], getStream(NORMAL_Y)[index], getStream(NORMAL_Z)[index]);
+
+    return vertex;
+}
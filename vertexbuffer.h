@@ -0,0 +1,60 @@
+#pragma once
+
+#include "math.h"
+#include "vertex.h"
+
+// Vertex data stored as a structure of arrays: one aligned float stream per position and
+// normal component, plus any number of extra attribute streams. Every stream has at least
+// LANES - 1 zeros of padding after the last vertex, so batch kernels can always load full
+// vectors.
+class VertexBuffer
+{
+public:
+    enum Stream : int
+    {
+        POSITION_X,
+        POSITION_Y,
+        POSITION_Z,
+        NORMAL_X,
+        NORMAL_Y,
+        NORMAL_Z,
+        ATTRIBUTE // First extra attribute stream
+    };
+
+    // Widest batch a kernel processes at once
+    static const int LANES = 8;
+
+    VertexBuffer(int count, int attributeStreams = 0);
+    VertexBuffer(const Vertex *vertices, int count, int attributeStreams = 0);
+    ~VertexBuffer();
+
+    VertexBuffer(const VertexBuffer &) = delete;
+    VertexBuffer &operator=(const VertexBuffer &) = delete;
+
+    void set(int index, const Vertex &vertex);
+    Vertex get(int index) const;
+
+    inline int getCount() const
+    {
+        return count;
+    }
+    inline int getStreamCount() const
+    {
+        return ATTRIBUTE + attributeStreams;
+    }
+
+    inline float *getStream(int stream)
+    {
+        return streams + stream * capacity;
+    }
+    inline const float *getStream(int stream) const
+    {
+        return streams + stream * capacity;
+    }
+
+private:
+    int count, capacity;
+    int attributeStreams;
+
+    float *streams = nullptr;
+};